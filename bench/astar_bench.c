@@ -0,0 +1,108 @@
+// 1000 A* queries on a 256x256 maze-ish grid: make bench && ./build/astar_bench
+#define _POSIX_C_SOURCE 199309L
+#include "astar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 256
+#define BENCH_WORDS ((BENCH_SIZE + 31) / 32)
+#define BENCH_QUERIES 1000
+
+static u32 g_solid[BENCH_SIZE * BENCH_WORDS];
+static v2i g_path[BENCH_SIZE * BENCH_SIZE];
+
+static u32 bench_rand(u32 *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+static void bench_setSolid(int x, int y)
+{
+  g_solid[x * BENCH_WORDS + (y >> 5)] |= 1u << (y & 31);
+}
+
+static int bench_isSolid(int x, int y)
+{
+  return (g_solid[x * BENCH_WORDS + (y >> 5)] >> (y & 31)) & 1u;
+}
+
+// room walls every 16 tiles with door gaps, plus scattered pillars
+static void bench_buildMap(u32 *seed)
+{
+  memset(g_solid, 0, sizeof(g_solid));
+  for (int x = 0; x < BENCH_SIZE; ++x)
+  {
+    for (int y = 0; y < BENCH_SIZE; ++y)
+    {
+      int edge = x == 0 || y == 0 || x == BENCH_SIZE - 1 || y == BENCH_SIZE - 1;
+      int wall = (x % 16 == 0 && y % 16 != 8) || (y % 16 == 0 && x % 16 != 8);
+      if (edge || wall || bench_rand(seed) % 100 < 12)
+        bench_setSolid(x, y);
+    }
+  }
+}
+
+static void bench_randomOpen(u32 *seed, int *x, int *y)
+{
+  do
+  {
+    *x = (int)(bench_rand(seed) % BENCH_SIZE);
+    *y = (int)(bench_rand(seed) % BENCH_SIZE);
+  } while (bench_isSolid(*x, *y));
+}
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+}
+
+static void bench_run(AStar *astar, const AStarGrid *grid, int diagonal)
+{
+  u32 seed = 12345u;
+  int found = 0;
+  long long expanded = 0;
+  long long tiles = 0;
+
+  double start = bench_now();
+  for (int i = 0; i < BENCH_QUERIES; ++i)
+  {
+    int sx, sy, gx, gy;
+    bench_randomOpen(&seed, &sx, &sy);
+    bench_randomOpen(&seed, &gx, &gy);
+    i32 length = astar_findPath(astar, grid, sx, sy, gx, gy, diagonal, g_path,
+                                BENCH_SIZE * BENCH_SIZE);
+    found += length > 0;
+    tiles += length;
+    expanded += astar->expanded;
+  }
+  double elapsed = bench_now() - start;
+
+  printf("[BENCH] A* %s: %d queries in %.2f ms (%.1f us/query), %d found, "
+         "avg path %.1f tiles, avg %.0f nodes expanded\n",
+         diagonal ? "octile   " : "manhattan", BENCH_QUERIES, elapsed,
+         elapsed * 1000.0 / BENCH_QUERIES, found,
+         found ? (double)tiles / found : 0.0,
+         (double)expanded / BENCH_QUERIES);
+}
+
+int main(void)
+{
+  u32 seed = 42u;
+  bench_buildMap(&seed);
+
+  AStar astar;
+  if (astar_init(&astar, BENCH_SIZE * BENCH_SIZE) != 0)
+    return 1;
+
+  const AStarGrid grid = {g_solid, BENCH_SIZE, BENCH_SIZE, BENCH_WORDS};
+  bench_run(&astar, &grid, 0);
+  bench_run(&astar, &grid, 1);
+
+  astar_free(&astar);
+  return 0;
+}
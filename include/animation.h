@@ -1,6 +1,8 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
+#include "mip.h"
+#include "pixel.h"
 #include "player.h"
 #include "types.h"
 #include <SDL.h>
@@ -25,8 +27,9 @@
 #define FRAMES_DEMON_WALK 4
 
 typedef struct {
-  u32 *pixels;
+  pixel_t *pixels;
   int width, height;
+  MipChain mips; // for sprites drawn far away, level 0 is `pixels`
 } Frame;
 
 typedef struct {
@@ -55,7 +58,7 @@ extern AnimationRegistry animations;
 
 void loadAllAnimations();
 void updateAllAnimations(Player *player, double deltaTime);
-void blitAnimation(u32 *buffer, Animation *animation, f32 width, f32 height,
+void blitAnimation(pixel_t *buffer, Animation *animation, f32 width, f32 height,
                    f32 x, f32 y, f32 scale);
 void freeAllAnimations();
 
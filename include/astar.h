@@ -0,0 +1,45 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include "types.h"
+
+/* Grid A* with an indexed binary heap. Node arrays are allocated once per
+ * context and stamped with a search generation instead of being cleared,
+ * so a query only touches the nodes it expands. Diagonal moves cost sqrt 2
+ * and never cut a solid corner. */
+
+// walkability as a column major bitmap, the layout of g_solidColumns
+typedef struct
+{
+  const u32 *solidColumns; // bit y of column x: [x * wordsPerColumn + y / 32]
+  i32 width;
+  i32 height;
+  i32 wordsPerColumn;
+} AStarGrid;
+
+typedef struct
+{
+  i32 capacity; // nodes, width * height of the largest grid searched
+  u32 generation;
+  u32 *stamp; // node state is only valid when stamp == generation
+  f32 *gScore;
+  f32 *fScore;
+  i32 *cameFrom;
+  i32 *heapIndex; // position in the heap, -1 once closed
+  i32 *heap;
+  i32 heapCount;
+  i32 expanded; // nodes expanded by the last query
+} AStar;
+
+// 0 on success
+int astar_init(AStar *astar, i32 capacity);
+void astar_free(AStar *astar);
+
+/* Writes start..goal into outPath and returns the tile count, 0 when the
+ * goal is unreachable or the path does not fit maxPath. The goal tile
+ * itself may be solid. */
+i32 astar_findPath(AStar *astar, const AStarGrid *grid, i32 startX,
+                   i32 startY, i32 goalX, i32 goalY, int allowDiagonal,
+                   v2i *outPath, i32 maxPath);
+
+#endif
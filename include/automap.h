@@ -0,0 +1,40 @@
+#ifndef AUTOMAP_H
+#define AUTOMAP_H
+
+#include "map.h"
+#include "pixel.h"
+#include "types.h"
+
+/* Automap fed by the wall DDA: every tile a ray walks through or hits is
+ * marked seen. The minimap image is cached and only the cells of newly
+ * seen or changed tiles are rasterized, the frame just blits it. */
+
+#define AUTOMAP_CELL 4 // pixels per tile
+#define AUTOMAP_WIDTH (MAP_WIDTH * AUTOMAP_CELL)
+#define AUTOMAP_HEIGHT (MAP_HEIGHT * AUTOMAP_CELL)
+#define AUTOMAP_MARGIN 8
+
+extern u8 g_automapSeen[MAP_WIDTH][MAP_HEIGHT];
+
+// slow path of automap_markSeen, draws the new cell
+void automap_noteSeen(int tileX, int tileY);
+
+// callers pass in-map coordinates; a load and a predicted branch per tile
+static inline void automap_markSeen(int tileX, int tileY)
+{
+  if (!g_automapSeen[tileX][tileY])
+    automap_noteSeen(tileX, tileY);
+}
+
+// forgets everything, on level load
+void automap_reset(void);
+// redraws the cell of a door that opened or closed
+void automap_onTileChanged(int tileX, int tileY);
+
+void automap_setEnabled(int enabled);
+int automap_isEnabled(void);
+
+// blits the cached map into the top right corner and adds the player marker
+void automap_draw(pixel_t *buffer, f64 posX, f64 posY, f64 dirX, f64 dirY);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef BLIT_H
+#define BLIT_H
+
+#include "pixel.h"
+#include "types.h"
+
+/* Row kernels for the per-pixel loops shared by the renderer and loaders.
+ * Every kernel has a scalar reference plus SSE2, SSE4.1 and AVX2 variants
+ * that must match it bit for bit; blit_init picks the best set the CPU
+ * supports. RAYCASTER_SIMD=scalar|sse2|sse4.1|avx2 caps the choice. */
+
+typedef enum
+{
+  BLIT_SCALAR = 0,
+  BLIT_SSE2,
+  BLIT_SSE41,
+  BLIT_AVX2,
+  BLIT_LEVELS,
+} BlitLevel;
+
+typedef struct
+{
+  BlitLevel level;
+  void (*clear)(pixel_t *dst, pixel_t value, int count);
+  // copies the src pixels that pixel_isOpaque, keeps dst elsewhere; never
+  // reads dst, so it may point into locked texture memory
+  void (*copyKeyed)(pixel_t *dst, const pixel_t *src, int count);
+  // ARGB8888 src over dst, (s * a + d * (255 - a) + 127) / 255 per channel;
+  // reads dst, keep it out of locked texture memory
+  void (*blendAlpha)(pixel_t *dst, const u32 *src, int count);
+  // dst[i] = src[(first + i) * srcCount / dstCount]
+  void (*scaleNearest)(pixel_t *dst, const pixel_t *src, int srcCount,
+                       int dstCount, int first, int count);
+  // half brightness, same as the old side wall shade
+  void (*shadeHalf)(pixel_t *dst, const pixel_t *src, int count);
+  /* in place dst[i] = lut[index], the index packs the top `bits` bits of
+   * blue, green and red with red lowest; RGB565 indexes by the pixel */
+  void (*gradeLUT)(pixel_t *dst, const pixel_t *lut, int bits, int count);
+} BlitKernels;
+
+extern BlitKernels g_blit;
+
+void blit_init(void);
+// NULL when the CPU or this build has no such variant
+const BlitKernels *blit_getKernels(BlitLevel level);
+const char *blit_levelName(BlitLevel level);
+
+#endif
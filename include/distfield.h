@@ -0,0 +1,24 @@
+#ifndef DISTFIELD_H
+#define DISTFIELD_H
+
+#include "map.h"
+#include "types.h"
+
+/* Chebyshev distance field for empty-space skipping in the wall DDA. A
+ * tile holding d has every tile less than d steps away (in x and y) open
+ * and already on the automap, so a ray can cross that square in one jump
+ * without missing a wall or an automap mark. Solid, unseen and off-map
+ * tiles count as blockers. */
+
+#define DISTFIELD_MAX 16 // larger squares still skip, just in several jumps
+
+extern u8 g_distField[MAP_WIDTH][MAP_HEIGHT];
+
+// full rebuild, after the map and the automap were reset
+void distfield_build(void);
+// a tile turned solid/open or got seen; recomputed on the next update
+void distfield_onTileChanged(int tileX, int tileY);
+// recomputes the area around the tiles changed since the last call
+void distfield_update(void);
+
+#endif
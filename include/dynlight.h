@@ -0,0 +1,34 @@
+#ifndef DYNLIGHT_H
+#define DYNLIGHT_H
+
+#include "map.h"
+#include "types.h"
+
+#define DYNLIGHT_MAX 64         // hard limit, sizes the light pool
+#define DYNLIGHT_DEFAULT_CAP 32 // simultaneous lights allowed by default
+#define DYNLIGHT_MAX_RADIUS 4   // in tiles, bounds the per light footprint
+#define DYNLIGHT_FOOTPRINT (DYNLIGHT_MAX_RADIUS * 2 + 1)
+
+// summed dynamic light per tile, already clamped to the shade LUT range
+extern u8 g_dynLightLevel[MAP_WIDTH][MAP_HEIGHT];
+
+static inline u32 dynlight_level(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return 0;
+  return g_dynLightLevel[tileX][tileY];
+}
+
+void dynlight_reset(void);
+void dynlight_setCap(int cap);
+int dynlight_getCap(void);
+int dynlight_getCount(void);
+
+/* Returns a handle, or -1 when the cap is reached. A lifetime of 0 keeps the
+ * light until dynlight_remove, otherwise it fades out over that time. */
+int dynlight_spawn(f32 x, f32 y, f32 radius, f32 intensity, f32 lifetime);
+void dynlight_move(int handle, f32 x, f32 y);
+void dynlight_remove(int handle);
+void dynlight_update(f64 deltaTime);
+
+#endif
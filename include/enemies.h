@@ -4,8 +4,13 @@
 #include "types.h"
 
 struct Engine;
+struct WeaponProperties;
 
-void enemies_applyHitscanDamage(struct Engine *engine, i32 damage);
+// fires the weapon's pellets from the player and applies the damage
+void enemies_applyHitscanDamage(struct Engine *engine,
+                                const struct WeaponProperties *weapon);
 void enemies_update(struct Engine *engine, double deltaTime);
+// forgets every enemy's last sighting, on level load
+void enemies_reset(void);
 
 #endif
@@ -2,6 +2,7 @@
 #define ENGINE_H
 
 #include "animation.h"
+#include "entitystore.h"
 #include "font.h"
 #include "graphics.h"
 #include "player.h"
@@ -20,7 +21,7 @@ typedef struct Engine {
   Player player;
   TextureManager textures;
   SoundManager sound;
-  Sprite *sprites;
+  EntityStore *entities;
   Font font;
 
   // Time tracking
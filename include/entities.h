@@ -1,17 +1,24 @@
 #ifndef ENTITIES_H
 #define ENTITIES_H
 
-#include "sprites.h"
+#include "entitystore.h"
+#include "spatialgrid.h"
 #include "types.h"
 
 struct Engine;
 
-Sprite *entities_createWorldSprites(void);
-Sprite *entities_getSprites(void);
-i32 entities_getSpriteCount(void);
+EntityStore *entities_createWorldSprites(void);
+EntityStore *entities_getStore(void);
 void entities_reset(void);
 void entities_getPlayerSpawn(double *outX, double *outY, double *outDirDegrees);
 void entities_tryInteract(struct Engine *engine);
+// active sprites bucketed by tile; whoever moves or retires a sprite updates it
+SpatialGrid *entities_getSpriteGrid(void);
+// adds a sprite to the store and the sprite grid; index -1 on failure
+EntityHandle entities_spawnSprite(SpriteKind kind, f64 x, f64 y, f32 scale,
+                                  Sprite sprite);
+// kills the sprite in the store and takes it out of the sprite grid
+void entities_retireSprite(i32 index);
 int entities_getLeverTextureAtFace(int tileX, int tileY, int faceX, int faceY,
                                    int *outActivated);
 int entities_getWallTextAt(int tileX, int tileY, int faceX, int faceY,
@@ -0,0 +1,81 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include "sprites.h"
+#include "types.h"
+#include <stdbool.h>
+
+/* Sprites split by how often they are touched. Position and scale live in
+ * their own f32 arrays so per-frame passes stream only those; appearance
+ * and gameplay state stay in the cold Sprite records. Each kind keeps a
+ * dense list of its live entities, updated on spawn and kill, so a system
+ * walks exactly the entities it cares about.
+ *
+ * The arrays grow on demand and never shrink. Killed slots go on a free
+ * stack and are reused first, so spawning and killing during play
+ * allocates nothing once the level has reached its peak count. */
+
+#define ENTITY_KIND_COUNT (SPRITE_DECAL + 1)
+#define ENTITY_INITIAL_CAPACITY 256
+
+// names one entity for as long as it lives; a reused slot does not match
+typedef struct
+{
+  i32 index;
+  u32 generation;
+} EntityHandle;
+
+typedef struct EntityStore
+{
+  // hot
+  f32 *x;
+  f32 *y;
+  f32 *scale;
+  u8 *kind;
+
+  // live entity indices per kind, in no particular order
+  i32 *live[ENTITY_KIND_COUNT];
+  i32 liveCount[ENTITY_KIND_COUNT];
+  i32 *livePos;     // slot in live[kind], -1 when not live
+  u32 *generation;  // bumped when the slot dies
+
+  i32 *freeSlots; // killed slots, reused last in first out
+  i32 freeCount;
+  i32 count; // slots handed out since the last clear, live or free
+  i32 capacity;
+  Sprite *cold;
+} EntityStore;
+
+void entitystore_free(EntityStore *store);
+// grows every array to hold capacity entities; 0 on success
+int entitystore_reserve(EntityStore *store, i32 capacity);
+// kills everything and keeps the memory
+void entitystore_clear(EntityStore *store);
+// the new entity's index, -1 when the store could not grow
+i32 entitystore_spawn(EntityStore *store, SpriteKind kind, f32 x, f32 y,
+                      f32 scale, const Sprite *cold);
+void entitystore_kill(EntityStore *store, i32 index);
+
+static inline bool entitystore_isLive(const EntityStore *store, i32 index)
+{
+  return index >= 0 && index < store->count && store->livePos[index] >= 0;
+}
+
+static inline EntityHandle entitystore_handle(const EntityStore *store,
+                                              i32 index)
+{
+  EntityHandle handle = {index, store->generation[index]};
+  return handle;
+}
+
+// the entity's index, -1 once it has died
+static inline i32 entitystore_resolve(const EntityStore *store,
+                                      EntityHandle handle)
+{
+  if (!entitystore_isLive(store, handle.index) ||
+      store->generation[handle.index] != handle.generation)
+    return -1;
+  return handle.index;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "map.h"
+#include "types.h"
+
+/* Breadth-first flow field over the walkable tiles toward one goal tile,
+ * shared by every enemy chasing that goal. Each tile stores the neighbour
+ * to step to, so following the field costs one load per enemy. */
+
+// recomputes only when the goal tile or the map changed since last time
+void flowfield_update(int goalX, int goalY);
+
+// 1 when the field currently leads to this goal tile
+int flowfield_hasGoal(int goalX, int goalY);
+
+// next tile toward the goal; 0 when at the goal or unreachable
+int flowfield_nextStep(int x, int y, v2i *outNext);
+
+#endif
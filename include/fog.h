@@ -0,0 +1,52 @@
+#ifndef FOG_H
+#define FOG_H
+
+#include "pixel.h"
+#include "types.h"
+
+#define FOG_LUT_SIZE 256 // distance buckets between the camera and far plane
+#define FOG_DEFAULT_START 6.0f
+#define FOG_DEFAULT_FAR 64.0f
+#define FOG_DEFAULT_MAX_STEPS 256
+#define FOG_DEFAULT_COLOR 0xFF1E1E1Eu
+#define FOG_FAR_PRESETS 4
+
+typedef struct
+{
+  int enabled;
+  f32 start;
+  f32 farDistance; // DDA stops and fog is opaque from here on
+  int maxSteps;    // DDA step cap, independent of the distance
+  u32 color;       // ARGB8888
+  pixel_t pixel;   // color in the framebuffer format
+  f32 lutScale;    // FOG_LUT_SIZE / farDistance
+  u16 weight[FOG_LUT_SIZE]; // 0..256 blend towards color per bucket
+} FogState;
+
+extern FogState g_fog;
+
+// fog blend weight for a view distance, 256 at and beyond the far plane
+static inline u32 fog_weight(f32 distance)
+{
+  int bucket = (int)(distance * g_fog.lutScale);
+  if (bucket >= FOG_LUT_SIZE)
+    return 256;
+  return g_fog.weight[bucket < 0 ? 0 : bucket];
+}
+
+static inline pixel_t fog_blend(pixel_t color, u32 weight)
+{
+  if (weight == 0)
+    return color;
+  return pixel_lerp(color, g_fog.pixel, weight);
+}
+
+void fog_resetLevelSettings(void);
+void fog_setEnabled(int enabled);
+void fog_setRange(f32 start, f32 farDistance);
+void fog_setColor(u32 color);
+void fog_setMaxSteps(int maxSteps);
+// steps through FOG_FAR_PRESETS draw distances, returns the new one
+f32 fog_cycleFarPlane(void);
+
+#endif
@@ -2,6 +2,7 @@
 #define FONT_H
 
 #include "SDL_ttf.h"
+#include "pixel.h"
 #include "types.h"
 
 #define FONTSIZE_TITLE 100
@@ -17,14 +18,14 @@ typedef struct {
 // init
 Font font_init();
 
-void renderText(u32 *Rbuffer, TTF_Font *font, const char *message, int x, int y,
+void renderText(pixel_t *Rbuffer, TTF_Font *font, const char *message, int x, int y,
                 SDL_Color color);
-void renderf32Pair(u32 *Rbuffer, TTF_Font *font, const char *label, double x,
+void renderf32Pair(pixel_t *Rbuffer, TTF_Font *font, const char *label, double x,
                      double y, int xpos, int ypos, SDL_Color color);
-void renderInt(u32 *Rbuffer, TTF_Font *font, const char *label, int value,
+void renderInt(pixel_t *Rbuffer, TTF_Font *font, const char *label, int value,
                int x, int y, SDL_Color color);
-void renderf32(u32 *Rbuffer, TTF_Font *font, const char *label, double value,
+void renderf32(pixel_t *Rbuffer, TTF_Font *font, const char *label, double value,
                  int x, int y, SDL_Color color);
-void renderProcent(u32 *Rbuffer, TTF_Font *font, int value, int x, int y,
+void renderProcent(pixel_t *Rbuffer, TTF_Font *font, int value, int x, int y,
                    SDL_Color color);
 #endif
@@ -7,6 +7,7 @@
 #define WINDOW_HEIGHT 800
 #define TITLE "Raycaster"
 
+#include "pixel.h"
 #include "types.h"
 
 // render to small internal Res
@@ -23,25 +24,38 @@
 #define RGB_Ceiling ((SDL_Color){50, 50, 50, 255})
 #define RGB_Floor ((SDL_Color){100, 100, 100, 255})
 
+// present swap chain (streaming textures we render into directly)
+#define SWAP_DOUBLE 2
+#define SWAP_TRIPLE 3
+#define SWAP_MAX SWAP_TRIPLE
+#define SWAP_DEFAULT SWAP_DOUBLE
+
 typedef struct {
   SDL_Window *window;
   SDL_Renderer *renderer;
-  SDL_Texture *screen_texture; // rendering target
+  SDL_Texture *screen_textures[SWAP_MAX]; // rendering targets
+  int swapCount;
+  int swapIndex;
   char *title;
   int window_width;
   int window_height;
-  u32 *buffer;
-  u32 *Rbuffer;
+  // locked texture memory while a frame is open: write-combined, so no
+  // stage may read it back; beginFrame picks Fbuffer when one has to
+  pixel_t *Rbuffer;
+  pixel_t *Fbuffer; // fallback target: padded pitch or a read-back stage
+  void *texPixels;  // locked texture memory (NULL if not locked)
+  int texPitch;     // pitch of the locked texture in bytes
   double *Zbuffer;
 } Game;
 
 Game createGame();
 
 void clearBuffer(Game *game);
-int buffers_reallocate(Game *game);
 int buffers_init(Game *game);
 int SDL_cleanup(Game *game, int exit_status);
 int SDL_initialize(Game *game);
+int graphics_setSwapCount(Game *game, int count);
+int beginFrame(Game *game);
 void drawBuffer(Game *game);
 
 #endif
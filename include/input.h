@@ -8,6 +8,12 @@
 #define UNGRAB_MOUSE SDL_SCANCODE_Q
 #define GUN_RELOAD SDL_SCANCODE_R
 #define CYCLE_GAME SDL_SCANCODE_G
+#define TOGGLE_TRIPLE_BUFFER SDL_SCANCODE_T
+#define CYCLE_UPSCALE SDL_SCANCODE_U
+#define TOGGLE_POST SDL_SCANCODE_P
+#define TOGGLE_FOG SDL_SCANCODE_F
+#define CYCLE_DRAW_DISTANCE SDL_SCANCODE_V
+#define TOGGLE_AUTOMAP SDL_SCANCODE_M
 #define MSB_LEFT SDL_BUTTON_LEFT
 
 int handleInput(Engine *engine, double deltaTime);
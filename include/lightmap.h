@@ -0,0 +1,61 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include "entitystore.h"
+#include "pixel.h"
+#include "types.h"
+
+#define LIGHT_FACE_RES 4      // light samples per tile edge (4x4 per face)
+#define LIGHT_LEVELS 64       // entries in the shade LUT
+#define LIGHT_LEVEL_ONE 32    // level that leaves a texel untouched
+#define LIGHT_AMBIENT_FLOOR 16
+#define LIGHT_AMBIENT_WALL_X 32 // faces hit with side == 0
+#define LIGHT_AMBIENT_WALL_Y 16 // faces hit with side == 1
+#define LIGHT_BAKE_RADIUS 6.0f
+#define LIGHT_BAKE_HEIGHT 0.8f
+#define LIGHT_BAKE_INTENSITY 40.0f
+#define LIGHT_MAX_SOURCES 64
+
+#ifdef PIXEL_RGB565
+// shade LUTs for the 5 and 6 bit channels
+extern u8 g_lightShade5[LIGHT_LEVELS][32];
+extern u8 g_lightShade6[LIGHT_LEVELS][64];
+
+static inline pixel_t lightmap_shade(pixel_t color, u32 level)
+{
+  return (pixel_t)((g_lightShade5[level][color >> 11] << 11) |
+                   (g_lightShade6[level][(color >> 5) & 0x3F] << 5) |
+                   g_lightShade5[level][color & 0x1F]);
+}
+#else
+// shade LUT, LIGHT_LEVELS rows of 256 scaled channel values
+extern u8 g_lightShade[LIGHT_LEVELS][256];
+
+static inline pixel_t lightmap_shade(pixel_t color, u32 level)
+{
+  const u8 *row = g_lightShade[level];
+  return 0xFF000000u | ((u32)row[(color >> 16) & 0xFF] << 16) |
+         ((u32)row[(color >> 8) & 0xFF] << 8) | (u32)row[color & 0xFF];
+}
+#endif
+
+static inline u32 lightmap_addLevel(u32 level, u32 extra)
+{
+  level += extra;
+  return level < LIGHT_LEVELS ? level : LIGHT_LEVELS - 1;
+}
+
+// collects light emitting decorations and bakes the whole map
+void lightmap_build(const EntityStore *entities);
+// re-bakes the tile, its neighbours' faces and the reach of lights covering it
+void lightmap_onTileChanged(int tileX, int tileY);
+// 1 when no solid tile lies between the two points
+int lightmap_traceVisible(f32 fromX, f32 fromY, f32 toX, f32 toY);
+
+// LIGHT_FACE_RES^2 levels, row major with row 0 at the top of the wall
+const u8 *lightmap_wallFace(int tileX, int tileY, int faceX, int faceY);
+// LIGHT_FACE_RES^2 levels, row major along world y then x
+const u8 *lightmap_floorTile(int tileX, int tileY);
+const u8 *lightmap_ceilingTile(int tileX, int tileY);
+
+#endif
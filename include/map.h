@@ -1,16 +1,48 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include "types.h"
+
 #define MAP_WIDTH 24
 #define MAP_HEIGHT 24
 
+// solidity bitmaps, one bit per tile packed into 32 bit words
+#define MAP_SOLID_WORDS_X ((MAP_WIDTH + 31) / 32)
+#define MAP_SOLID_WORDS_Y ((MAP_HEIGHT + 31) / 32)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern int worldMap[MAP_WIDTH][MAP_HEIGHT];
+
+/* worldMap keeps texture ids; "is this tile solid" is answered from these
+ * bit copies, column major (bit y of column x) for the DDA and row major
+ * (bit x of row y) for scans along a row. Both follow worldMap through
+ * map_setTile and map_syncSolidity. */
+extern u32 g_solidColumns[MAP_WIDTH][MAP_SOLID_WORDS_Y];
+extern u32 g_solidRows[MAP_HEIGHT][MAP_SOLID_WORDS_X];
+
+// bumped whenever a tile changes, so caches built from the map can tell
+extern u32 g_mapRevision;
+
+// callers pass in-map coordinates
+static inline int map_isSolid(int x, int y)
+{
+  return (int)((g_solidColumns[x][y >> 5] >> (y & 31)) & 1u);
+}
+
+static inline int map_isSolidInRow(int x, int y)
+{
+  return (int)((g_solidRows[y][x >> 5] >> (x & 31)) & 1u);
+}
+
 int map_loadFromCSV(const char *filepath);
 void map_resetToDefault(void);
+// writes a tile and its solidity bits
+void map_setTile(int x, int y, int value);
+// rebuilds both bitmaps after worldMap was written directly
+void map_syncSolidity(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,45 @@
+#ifndef MIP_H
+#define MIP_H
+
+#include "pixel.h"
+#include "types.h"
+
+/* Box-filtered mip chains for sprite sources. Level 0 is the caller's
+ * image, every further level halves both axes down to 1x1 or
+ * MIP_MAX_LEVELS. Transparent texels are left out of the average and a
+ * texel stays opaque when at least two of its four sources are, so far
+ * sprites keep their silhouette instead of fading into the key colour. */
+
+#define MIP_MAX_LEVELS 8
+
+typedef enum
+{
+  MIP_KEY_ALPHA = 0, // animation frames, transparent = !pixel_isOpaque
+  MIP_KEY_COLOR,     // textures, transparent = pixel_isColorKey
+} MipKey;
+
+typedef struct
+{
+  const pixel_t *pixels[MIP_MAX_LEVELS];
+  i32 width[MIP_MAX_LEVELS];
+  i32 height[MIP_MAX_LEVELS];
+  i32 levels;
+  pixel_t *storage; // levels 1.. in one block, level 0 is not owned
+} MipChain;
+
+// 0 on success; on failure the chain still holds level 0
+int mip_build(MipChain *chain, const pixel_t *base, i32 width, i32 height,
+              MipKey key);
+void mip_free(MipChain *chain);
+
+// smallest level that still has at least screenHeight rows
+static inline i32 mip_selectLevel(const MipChain *chain, i32 screenHeight)
+{
+  i32 level = 0;
+  while (level + 1 < chain->levels &&
+         chain->height[level + 1] >= screenHeight)
+    ++level;
+  return level;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include "types.h"
+
+/* Pixel format shared by Rbuffer, textures and animation frames. ARGB8888
+ * by default; building with -DPIXEL_RGB565 (make RGB565=1) switches the
+ * whole pipeline to 16 bit, halving framebuffer and texture bandwidth.
+ * Sources (image files, fonts) are always decoded as ARGB8888 and go
+ * through pixel_fromARGB once at load time. */
+
+#ifdef PIXEL_RGB565
+
+typedef u16 pixel_t;
+#define PIXEL_SDL_FORMAT SDL_PIXELFORMAT_RGB565
+// 565 has no alpha, fully transparent texels become this magenta key
+#define PIXEL_TRANSPARENT 0xF81Fu
+
+static inline pixel_t pixel_fromARGB(u32 color)
+{
+  if ((color >> 24) == 0)
+    return PIXEL_TRANSPARENT;
+  u32 p = ((color >> 8) & 0xF800u) | ((color >> 5) & 0x07E0u) |
+          ((color >> 3) & 0x001Fu);
+  // keep opaque magenta from turning into holes
+  return (pixel_t)(p == PIXEL_TRANSPARENT ? p - 1 : p);
+}
+
+static inline u32 pixel_toARGB(pixel_t p)
+{
+  u32 r = (p >> 11) & 0x1F;
+  u32 g = (p >> 5) & 0x3F;
+  u32 b = p & 0x1F;
+  return 0xFF000000u | ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) |
+         (b << 3 | b >> 2);
+}
+
+static inline int pixel_isOpaque(pixel_t p)
+{
+  return p != PIXEL_TRANSPARENT;
+}
+
+// texture sprites are keyed on black
+static inline int pixel_isColorKey(pixel_t p)
+{
+  return p == 0 || p == PIXEL_TRANSPARENT;
+}
+
+// w in [0, 256]; G is moved to the top half so all three channels blend in
+// one multiply
+static inline pixel_t pixel_lerp(pixel_t a, pixel_t b, u32 w)
+{
+  u32 w5 = w >> 3;
+  u32 ea = ((u32)a | ((u32)a << 16)) & 0x07E0F81Fu;
+  u32 eb = ((u32)b | ((u32)b << 16)) & 0x07E0F81Fu;
+  u32 mixed = ((ea * (32u - w5) + eb * w5) >> 5) & 0x07E0F81Fu;
+  return (pixel_t)(mixed | (mixed >> 16));
+}
+
+#else
+
+typedef u32 pixel_t;
+#define PIXEL_SDL_FORMAT SDL_PIXELFORMAT_ARGB8888
+
+static inline pixel_t pixel_fromARGB(u32 color)
+{
+  return color;
+}
+
+static inline u32 pixel_toARGB(pixel_t p)
+{
+  return p;
+}
+
+static inline int pixel_isOpaque(pixel_t p)
+{
+  return (p & 0xFF000000u) != 0;
+}
+
+static inline int pixel_isColorKey(pixel_t p)
+{
+  return (p & 0x00FFFFFFu) == 0;
+}
+
+// w in [0, 256], two channels per multiply
+static inline pixel_t pixel_lerp(pixel_t a, pixel_t b, u32 w)
+{
+  u32 inv = 256u - w;
+  u32 rb = (((a & 0x00FF00FFu) * inv + (b & 0x00FF00FFu) * w) >> 8) &
+           0x00FF00FFu;
+  u32 ag = (((a >> 8) & 0x00FF00FFu) * inv + ((b >> 8) & 0x00FF00FFu) * w) &
+           0xFF00FF00u;
+  return ag | rb;
+}
+
+#endif
+
+#endif
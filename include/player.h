@@ -3,9 +3,10 @@
 
 #include "SDL.h"
 #include "map.h"
+#include "spatialgrid.h"
 #include <stdbool.h>
 
-typedef struct Sprite Sprite;
+typedef struct EntityStore EntityStore;
 
 #define CLAMP 160
 #define POS_X 22.0
@@ -51,11 +52,11 @@ Player createPlayer();
 
 // movement
 void player_move(Player *player, double deltaTime,
-                 int worldMap[MAP_HEIGHT][MAP_WIDTH], Sprite *sprites,
-                 int spriteCount, int direction);
+                 const EntityStore *entities, const SpatialGrid *grid,
+                 int direction);
 void player_strafe(Player *player, double deltaTime,
-                   int worldMap[MAP_HEIGHT][MAP_WIDTH], Sprite *sprites,
-                   int spriteCount, int direction);
+                   const EntityStore *entities, const SpatialGrid *grid,
+                   int direction);
 
 void player_rotate(Player *player, double rotationAmount);
 double mouse_rotationAmount(double sensX, Sint16 xrel);
@@ -0,0 +1,31 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+
+#include "types.h"
+
+// baked LUT resolution (per channel), looked up with the top 6 bits
+#define POST_LUT_BITS 6
+#define POST_LUT_GRID (1 << POST_LUT_BITS)
+#ifdef PIXEL_RGB565
+// every 565 colour has its own entry, indexed by the pixel itself
+#define POST_LUT_ENTRIES 65536
+#else
+#define POST_LUT_ENTRIES (POST_LUT_GRID * POST_LUT_GRID * POST_LUT_GRID)
+#endif
+// biggest .cube we accept
+#define POST_LUT_MAX_SIZE 65
+
+struct Engine;
+
+void post_resetLevelSettings(void);
+int post_loadLUT(const char *path);
+void post_setEnabled(int enabled);
+int post_isEnabled(void);
+// 1 when post_apply will read the frame back this frame
+int post_readsFrame(void);
+void post_cleanup(void);
+
+// colour grades Rbuffer through the LUT, row-parallel
+void post_apply(struct Engine *engine);
+
+#endif
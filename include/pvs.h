@@ -0,0 +1,36 @@
+#ifndef PVS_H
+#define PVS_H
+
+#include "map.h"
+#include "types.h"
+
+/* Tile to tile potentially visible set over worldMap. Conservative: bit
+ * (A, B) is set whenever some sightline between points of the open tiles A
+ * and B crosses no solid tile. Built from ray fans out of every tile edge,
+ * dilated by one tile and made symmetric. A solid tile counts as seen when
+ * one of its open neighbours is. */
+
+#define PVS_TILES (MAP_WIDTH * MAP_HEIGHT)
+#define PVS_WORDS ((PVS_TILES + 63) / 64)
+
+extern u64 g_pvs[PVS_TILES][PVS_WORDS];
+
+static inline int pvs_index(int x, int y)
+{
+  return x * MAP_HEIGHT + y;
+}
+
+static inline int pvs_testBit(int from, int to)
+{
+  return (int)((g_pvs[from][to >> 6] >> (to & 63)) & 1u);
+}
+
+// full rebuild, at level load
+void pvs_build(void);
+// re-casts only the rays of tiles whose fans reach the changed tile
+void pvs_onTileChanged(int tileX, int tileY);
+
+// O(1); positions outside the map are treated as visible
+int pvs_canSee(int fromX, int fromY, int toX, int toY);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RAYQUERY_H
+#define RAYQUERY_H
+
+#include "map.h"
+#include "types.h"
+
+/* Gameplay ray queries against the map solidity bits: hitscan, line of sight and
+ * anything else that needs "where does this ray stop". Rays are traced in
+ * packets of 4 (SSE2) or 8 (AVX2) lanes of the same DDA the renderer
+ * uses; every variant returns exactly what the scalar one does. */
+
+// a DDA leaves the map after at most this many steps
+#define RAYQUERY_MAX_STEPS (MAP_WIDTH + MAP_HEIGHT + 2)
+
+typedef struct
+{
+  f32 distance; // along dir, in units of |dir|; the exit distance on a miss
+  i32 tileX;
+  i32 tileY;
+  i32 side; // 0 = crossed an x grid line (NS face), 1 = y grid line
+  i32 hit;  // 0 when the ray left the map or passed maxDistance
+} RayHit;
+
+/* Casts `count` rays given as structure of arrays. A ray stops at the first
+ * solid tile or once the next grid crossing lies beyond its maxDistance. */
+void rayquery_cast(const f32 *originX, const f32 *originY, const f32 *dirX,
+                   const f32 *dirY, const f32 *maxDistance, RayHit *out,
+                   int count);
+
+// outClear[i] = 1 when no solid tile lies between from[i] and to[i]
+void rayquery_lineOfSight(const f32 *fromX, const f32 *fromY, const f32 *toX,
+                          const f32 *toY, u8 *outClear, int count);
+
+#endif
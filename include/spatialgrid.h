@@ -0,0 +1,68 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include "map.h"
+#include "types.h"
+
+/* Tile aligned bucket grid over item ids (sprite or lever indices). Every
+ * cell holds an intrusive doubly linked list, so insert, move and remove
+ * are O(1) and a query only walks the cells it touches. Positions outside
+ * the map are clamped into the border cells. */
+
+#define SPATIAL_CELLS (MAP_WIDTH * MAP_HEIGHT)
+
+typedef struct
+{
+  i32 head[SPATIAL_CELLS]; // first id per cell, -1 when empty
+  i32 *next;
+  i32 *prev;
+  i32 *cell; // cell of each id, -1 when not in the grid
+  i32 capacity;
+} SpatialGrid;
+
+// 0 on success
+int spatialgrid_init(SpatialGrid *grid, i32 capacity);
+void spatialgrid_free(SpatialGrid *grid);
+// grows the per-id arrays, keeps what is stored; 0 on success
+int spatialgrid_reserve(SpatialGrid *grid, i32 capacity);
+void spatialgrid_clear(SpatialGrid *grid);
+
+// inserts the id, or moves it when it is already in the grid
+void spatialgrid_update(SpatialGrid *grid, i32 id, f64 x, f64 y);
+void spatialgrid_remove(SpatialGrid *grid, i32 id);
+
+static inline i32 spatialgrid_cellOf(f64 x, f64 y)
+{
+  i32 cx = (i32)x;
+  i32 cy = (i32)y;
+  cx = cx < 0 ? 0 : (cx >= MAP_WIDTH ? MAP_WIDTH - 1 : cx);
+  cy = cy < 0 ? 0 : (cy >= MAP_HEIGHT ? MAP_HEIGHT - 1 : cy);
+  return cx * MAP_HEIGHT + cy;
+}
+
+// walk one cell: for (id = first(cx, cy); id >= 0; id = next(id))
+static inline i32 spatialgrid_first(const SpatialGrid *grid, i32 cellX,
+                                    i32 cellY)
+{
+  return grid->head[cellX * MAP_HEIGHT + cellY];
+}
+
+static inline i32 spatialgrid_next(const SpatialGrid *grid, i32 id)
+{
+  return grid->next[id];
+}
+
+/* Candidates near (x, y): every id in the cells the square of half size
+ * `radius` touches. Callers do their own exact distance test. Returns the
+ * count written, at most maxOut. */
+i32 spatialgrid_queryRadius(const SpatialGrid *grid, f64 x, f64 y,
+                            f64 radius, i32 *out, i32 maxOut);
+
+/* Candidates along a ray: ids in the cells the ray crosses up to
+ * maxDistance (in units of |dir|), widened by `halfWidth` cells on every
+ * side, each listed once, roughly in order along the ray. */
+i32 spatialgrid_queryRay(const SpatialGrid *grid, f64 originX, f64 originY,
+                         f64 dirX, f64 dirY, f64 maxDistance, i32 halfWidth,
+                         i32 *out, i32 maxOut);
+
+#endif
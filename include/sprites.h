@@ -4,8 +4,6 @@
 #include "animation.h"
 #include "types.h"
 
-#define NUM_SPRITES 256
-
 // Texture index macros (kept for legacy sprite setup convenience)
 #define TEX_PILLAR 13
 #define TEX_BARREL 14
@@ -50,18 +48,12 @@ typedef struct
   };
 } SpriteAppearance;
 
+// cold per-sprite state; position, scale and kind live in the EntityStore
 typedef struct Sprite
 {
-  f64 x;
-  f64 y;
-  f32 scale;
-  SpriteKind kind;
   SpriteAppearance appearance;
-  i32 active;
   i32 health;
   i32 auxTextureId;
-  i32 targetX;
-  i32 targetY;
   i32 actionType;
   i32 stateFlags;
 } Sprite;
@@ -69,11 +61,17 @@ typedef struct Sprite
 // forward declaration
 struct Engine;
 
+typedef struct
+{
+  f64 distance; // squared, to the player
+  i32 index;
+} SpriteDepth;
+
 SpriteAppearance spriteAppearanceFromTexture(i32 textureId);
 SpriteAppearance spriteAppearanceFromAnimation(Animation *animation);
 
 // calculations
 void perform_spritecasting(struct Engine *engine);
-void sortSprites(i32 *order, f64 *dist, i32 amount);
+void sortSprites(SpriteDepth *depths, i32 amount);
 
 #endif
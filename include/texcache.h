@@ -0,0 +1,50 @@
+#ifndef TEXCACHE_H
+#define TEXCACHE_H
+
+#include "pixel.h"
+#include "texture.h"
+#include "types.h"
+#include <stddef.h>
+
+/* Residency manager for high-resolution wall and floor textures. The
+ * TEXT_WIDTH x TEXT_HEIGHT copies in TextureManager stay resident and are
+ * what the renderer samples until the high-res level of a texture has been
+ * loaded by the background thread. High-res levels are power-of-two sized
+ * up to TEXCACHE_MAX_SIZE, loaded the first time a texture is seen and
+ * evicted least recently used when the budget is exceeded. A level that did
+ * not fit is only loaded again once the budget has room for it. */
+
+#define TEXCACHE_MAX_SIZE 512
+#define TEXCACHE_DEFAULT_BUDGET (24u * 1024u * 1024u)
+// high-res pack, mirrors the layout below assets/textures/
+#define TEXCACHE_PACK_DIR "assets/textures_hd/"
+
+// what the render kernels sample: size, row shift and wrap masks
+typedef struct
+{
+  const pixel_t *pixels;
+  i32 width;
+  i32 height;
+  i32 shiftX; // log2(width), row stride
+  i32 shiftY; // log2(height)
+  u32 maskX;
+  u32 maskY;
+} TextureView;
+
+int texcache_init(const TextureManager *tm);
+void texcache_shutdown(void);
+
+/* Best resident level of a texture, marks it as seen this frame. Main
+ * thread only; the first call for a texture queues its high-res load.
+ * Ids outside [0, NUM_TEXTURES) get the low-res texture 0. */
+TextureView texcache_view(int id);
+
+// once per frame on the main thread: installs finished loads, evicts
+void texcache_update(void);
+
+void texcache_setBudget(size_t bytes);
+size_t texcache_getBudget(void);
+size_t texcache_getResidentBytes(void);
+int texcache_getResidentCount(void);
+
+#endif
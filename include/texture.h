@@ -1,6 +1,8 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include "mip.h"
+#include "pixel.h"
 #include "types.h"
 #include <stdint.h>
 
@@ -18,7 +20,8 @@
    NUM_DECAL_TEXTURES)
 
 typedef struct {
-  u32 *textures[NUM_TEXTURES];
+  pixel_t *textures[NUM_TEXTURES];
+  MipChain mips[NUM_TEXTURES]; // sprite LODs, level 0 is textures[i]
 } TextureManager;
 
 typedef struct {
@@ -60,8 +63,14 @@ TextureManager createTextures();
 int textures_load(TextureManager *tm);
 
 // loading
-void loadImage(u32 *texture, int width, int height, const char *filename);
+// 0 on success; on failure the texture is left black
+int loadImage(pixel_t *texture, int width, int height, const char *filename);
+// native size rounded down to powers of two, clamped to maxSize; malloc'd,
+// NULL when the file can't be loaded
+pixel_t *loadImagePow2(const char *filename, int maxSize, int *outWidth,
+                       int *outHeight);
 void loadArrays(TextureManager *tm, int texWidth, int texHeight);
 int getTextureIndexByName(const char *name);
+const char *getTexturePath(int index);
 
 #endif
@@ -0,0 +1,20 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#define THREADS_MAX 16
+// chunks handed out per thread, so uneven bands still balance out
+#define THREADS_CHUNKS_PER_THREAD 4
+
+// work callback, processes the half-open index range [begin, end)
+typedef void (*ThreadJobFn)(void *ctx, int begin, int end);
+
+int threads_init(int workerCount);
+void threads_shutdown(void);
+int threads_getWorkerCount(void);
+
+/* Splits [0, count) into chunks and runs them on the worker pool plus the
+ * calling thread, returns once every chunk is done. Not re-entrant: must not
+ * be called from inside a job. */
+void threads_parallelFor(int count, ThreadJobFn fn, void *ctx);
+
+#endif
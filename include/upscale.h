@@ -0,0 +1,27 @@
+#ifndef UPSCALE_H
+#define UPSCALE_H
+
+#include "graphics.h"
+
+typedef enum {
+  UPSCALE_SDL = 0,        // let SDL_RenderCopy stretch the render target
+  UPSCALE_NEAREST,        // integer nearest, letterboxed
+  UPSCALE_SHARP_BILINEAR, // integer prescale + bilinear, fills the window
+  UPSCALE_SCANLINE,       // integer nearest with darkened scanlines
+  UPSCALE_TOTAL,
+} UpscaleFilter;
+
+int upscale_init(Game *game);
+void upscale_cleanup(void);
+// drops the window sized textures of swap slots that are no longer used
+void upscale_setSwapCount(int count);
+
+void upscale_setFilter(UpscaleFilter filter);
+UpscaleFilter upscale_getFilter(void);
+int upscale_isActive(void);
+const char *upscale_filterName(UpscaleFilter filter);
+
+// scales Rbuffer into a window sized texture and copies it to the renderer
+int upscale_present(Game *game);
+
+#endif
@@ -5,13 +5,15 @@
 #include "player.h"
 #include "types.h"
 
-typedef struct
+typedef struct WeaponProperties
 {
   i32 automatic;
   f64 fireRate;
   f64 fireAccumulator;
   i32 ammunition;
-  i32 damage;
+  i32 damage;  // per shot, split evenly over the pellets
+  i32 pellets; // rays per shot
+  f64 spread;  // full horizontal cone of the pellets, radians
 } WeaponProperties;
 
 extern WeaponProperties weaponProperties[TOTAL_GUNS];
@@ -1,5 +1,7 @@
 #include "animation.h"
 #include "SDL_surface.h"
+#include "blit.h"
+#include "graphics.h"
 #include "player.h"
 #include "types.h"
 #include <SDL.h>
@@ -27,7 +29,7 @@ Frame loadFrame(const char *path) {
   int width = converted->w;
   int height = converted->h;
 
-  u32 *pixels = malloc(width * height * sizeof(u32));
+  pixel_t *pixels = malloc(width * height * sizeof(pixel_t));
   if (!pixels)
     fprintf(stderr, "\033[31m[ERROR] Failed to allocate buffer:  %s\033[0m\n",
             SDL_GetError());
@@ -42,14 +44,15 @@ Frame loadFrame(const char *path) {
       int dstindex = y * width + x;
 
       u32 color = image[image_index];
-      pixels[dstindex] = color;
+      pixels[dstindex] = pixel_fromARGB(color);
     }
   }
 
   SDL_FreeSurface(surface);
   SDL_FreeSurface(converted);
 
-  Frame frame = {pixels, width, height};
+  Frame frame = {.pixels = pixels, .width = width, .height = height};
+  mip_build(&frame.mips, pixels, width, height, MIP_KEY_ALPHA);
   return frame;
 }
 
@@ -149,37 +152,43 @@ void updateAllAnimations(Player *player, double deltaTime) {
   updateAnimation(&animations.demon_walk, NULL, deltaTime);
 }
 
-void blitFrame(u32 *buffer, Frame *frame, f32 width, f32 height, f32 x,
+void blitFrame(pixel_t *buffer, Frame *frame, f32 width, f32 height, f32 x,
                f32 y, f32 scale) {
 
   int scaled_height = (int)frame->height * scale;
   int scaled_width = (int)frame->width * scale;
-  for (int dsty = 0; dsty < scaled_height; dsty++) {
-    for (int dstx = 0; dstx < scaled_width; dstx++) {
-      int imgy = (int)dsty / scale;
-      int imgx = (int)dstx / scale;
-
-      int screenX = dstx + x;
-      int screenY = dsty + y;
-
-      if (screenX < 0 || screenX >= width || screenY < 0 || screenY >= height) {
-        continue;
-      }
-
-      int image_index = imgy * frame->width + imgx;
-      u32 color = frame->pixels[image_index];
+  if (scaled_width <= 0 || scaled_height <= 0)
+    return;
 
-      if ((color & 0xFF000000) == 0) {
-        continue;
-      }
+  // clip the scaled frame against the target once, then blit whole rows
+  int originX = (int)x;
+  int originY = (int)y;
+  int firstX = originX < 0 ? -originX : 0;
+  int lastX = scaled_width;
+  if (originX + lastX > (int)width)
+    lastX = (int)width - originX;
+  if (lastX - firstX > RENDER_WIDTH)
+    lastX = firstX + RENDER_WIDTH;
+  int count = lastX - firstX;
+  if (count <= 0)
+    return;
 
-      int dstIndex = screenY * width + screenX;
-      buffer[dstIndex] = color;
+  pixel_t row[RENDER_WIDTH];
+  for (int dsty = 0; dsty < scaled_height; dsty++) {
+    int screenY = dsty + originY;
+    if (screenY < 0 || screenY >= height) {
+      continue;
     }
+
+    int imgy = dsty * frame->height / scaled_height;
+    g_blit.scaleNearest(row, frame->pixels + imgy * frame->width, frame->width,
+                        scaled_width, firstX, count);
+    g_blit.copyKeyed(buffer + screenY * (int)width + originX + firstX, row,
+                     count);
   }
 }
 
-void blitAnimation(u32 *buffer, Animation *animation, f32 width, f32 height,
+void blitAnimation(pixel_t *buffer, Animation *animation, f32 width, f32 height,
                    f32 x, f32 y, f32 scale) {
   Frame *currentFrame = &animation->frames[animation->currentFrame];
 
@@ -187,6 +196,7 @@ void blitAnimation(u32 *buffer, Animation *animation, f32 width, f32 height,
 }
 
 void freeFrame(Frame *frame) {
+  mip_free(&frame->mips);
   if (frame->pixels) {
     free(frame->pixels);
     frame->pixels = NULL;
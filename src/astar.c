@@ -0,0 +1,251 @@
+#include "astar.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASTAR_DIAGONAL_COST 1.41421356f
+
+static inline int astar_isSolid(const AStarGrid *grid, i32 x, i32 y)
+{
+  return (int)((grid->solidColumns[x * grid->wordsPerColumn + (y >> 5)] >>
+                (y & 31)) &
+               1u);
+}
+
+static inline f32 astar_heuristic(i32 x, i32 y, i32 goalX, i32 goalY,
+                                  int allowDiagonal)
+{
+  i32 dx = abs(x - goalX);
+  i32 dy = abs(y - goalY);
+  if (!allowDiagonal)
+    return (f32)(dx + dy);
+  // octile distance
+  i32 lo = dx < dy ? dx : dy;
+  i32 hi = dx < dy ? dy : dx;
+  return (f32)(hi - lo) + ASTAR_DIAGONAL_COST * (f32)lo;
+}
+
+int astar_init(AStar *astar, i32 capacity)
+{
+  memset(astar, 0, sizeof(*astar));
+  astar->stamp = calloc((size_t)capacity, sizeof(u32));
+  astar->gScore = malloc((size_t)capacity * sizeof(f32));
+  astar->fScore = malloc((size_t)capacity * sizeof(f32));
+  astar->cameFrom = malloc((size_t)capacity * sizeof(i32));
+  astar->heapIndex = malloc((size_t)capacity * sizeof(i32));
+  astar->heap = malloc((size_t)capacity * sizeof(i32));
+  if (!astar->stamp || !astar->gScore || !astar->fScore || !astar->cameFrom ||
+      !astar->heapIndex || !astar->heap)
+  {
+    fprintf(stderr, "\033[31m[ERROR] Failed to allocate A* nodes\033[0m\n");
+    astar_free(astar);
+    return -1;
+  }
+  astar->capacity = capacity;
+  return 0;
+}
+
+void astar_free(AStar *astar)
+{
+  free(astar->stamp);
+  free(astar->gScore);
+  free(astar->fScore);
+  free(astar->cameFrom);
+  free(astar->heapIndex);
+  free(astar->heap);
+  memset(astar, 0, sizeof(*astar));
+}
+
+// ties go to the node with the larger g, the one closer to the goal
+static inline int astar_before(const AStar *astar, i32 a, i32 b)
+{
+  f32 fa = astar->fScore[a];
+  f32 fb = astar->fScore[b];
+  if (fa != fb)
+    return fa < fb;
+  return astar->gScore[a] > astar->gScore[b];
+}
+
+static void astar_siftUp(AStar *astar, i32 pos)
+{
+  i32 node = astar->heap[pos];
+  while (pos > 0)
+  {
+    i32 parent = (pos - 1) >> 1;
+    i32 parentNode = astar->heap[parent];
+    if (!astar_before(astar, node, parentNode))
+      break;
+    astar->heap[pos] = parentNode;
+    astar->heapIndex[parentNode] = pos;
+    pos = parent;
+  }
+  astar->heap[pos] = node;
+  astar->heapIndex[node] = pos;
+}
+
+static void astar_siftDown(AStar *astar, i32 pos)
+{
+  i32 node = astar->heap[pos];
+  const i32 count = astar->heapCount;
+  for (;;)
+  {
+    i32 child = 2 * pos + 1;
+    if (child >= count)
+      break;
+    if (child + 1 < count &&
+        astar_before(astar, astar->heap[child + 1], astar->heap[child]))
+      child++;
+    if (!astar_before(astar, astar->heap[child], node))
+      break;
+    astar->heap[pos] = astar->heap[child];
+    astar->heapIndex[astar->heap[pos]] = pos;
+    pos = child;
+  }
+  astar->heap[pos] = node;
+  astar->heapIndex[node] = pos;
+}
+
+static i32 astar_popMin(AStar *astar)
+{
+  i32 top = astar->heap[0];
+  astar->heapCount--;
+  if (astar->heapCount > 0)
+  {
+    astar->heap[0] = astar->heap[astar->heapCount];
+    astar_siftDown(astar, 0);
+  }
+  astar->heapIndex[top] = -1;
+  return top;
+}
+
+// first touch of a node in this search
+static inline void astar_visit(AStar *astar, i32 node)
+{
+  astar->stamp[node] = astar->generation;
+  astar->gScore[node] = INFINITY;
+  astar->cameFrom[node] = -1;
+  astar->heapIndex[node] = -2; // neither open nor closed yet
+}
+
+i32 astar_findPath(AStar *astar, const AStarGrid *grid, i32 startX,
+                   i32 startY, i32 goalX, i32 goalY, int allowDiagonal,
+                   v2i *outPath, i32 maxPath)
+{
+  static const i32 directions[8][2] = {{1, 0},  {-1, 0}, {0, 1},  {0, -1},
+                                       {1, 1},  {1, -1}, {-1, 1}, {-1, -1}};
+
+  astar->expanded = 0;
+  if (!outPath || maxPath <= 0 || !grid)
+    return 0;
+  if (grid->width * grid->height > astar->capacity)
+    return 0;
+  if (startX < 0 || startY < 0 || startX >= grid->width ||
+      startY >= grid->height || goalX < 0 || goalY < 0 ||
+      goalX >= grid->width || goalY >= grid->height)
+    return 0;
+
+  if (startX == goalX && startY == goalY)
+  {
+    outPath[0].x = startX;
+    outPath[0].y = startY;
+    return 1;
+  }
+  if (astar_isSolid(grid, startX, startY))
+    return 0;
+
+  // a wrapped generation would match stale stamps, start over from zero
+  if (++astar->generation == 0)
+  {
+    memset(astar->stamp, 0, (size_t)astar->capacity * sizeof(u32));
+    astar->generation = 1;
+  }
+
+  const i32 height = grid->height;
+  const i32 startIndex = startX * height + startY;
+  const i32 goalIndex = goalX * height + goalY;
+  const int directionCount = allowDiagonal ? 8 : 4;
+
+  astar_visit(astar, startIndex);
+  astar->gScore[startIndex] = 0.0f;
+  astar->fScore[startIndex] =
+      astar_heuristic(startX, startY, goalX, goalY, allowDiagonal);
+  astar->heapCount = 1;
+  astar->heap[0] = startIndex;
+  astar->heapIndex[startIndex] = 0;
+
+  while (astar->heapCount > 0)
+  {
+    i32 current = astar_popMin(astar);
+    astar->expanded++;
+
+    if (current == goalIndex)
+    {
+      i32 length = 0;
+      for (i32 node = goalIndex; node >= 0; node = astar->cameFrom[node])
+      {
+        if (length >= maxPath)
+          return 0;
+        outPath[length].x = node / height;
+        outPath[length].y = node % height;
+        length++;
+      }
+      for (i32 i = 0; i < length / 2; ++i)
+      {
+        v2i tmp = outPath[i];
+        outPath[i] = outPath[length - 1 - i];
+        outPath[length - 1 - i] = tmp;
+      }
+      return length;
+    }
+
+    const i32 currentX = current / height;
+    const i32 currentY = current % height;
+    const f32 currentG = astar->gScore[current];
+
+    for (int d = 0; d < directionCount; ++d)
+    {
+      i32 nx = currentX + directions[d][0];
+      i32 ny = currentY + directions[d][1];
+      if (nx < 0 || ny < 0 || nx >= grid->width || ny >= height)
+        continue;
+
+      i32 neighbor = nx * height + ny;
+      if (astar_isSolid(grid, nx, ny) && neighbor != goalIndex)
+        continue;
+
+      f32 stepCost = 1.0f;
+      if (d >= 4)
+      {
+        // no squeezing diagonally past a wall corner
+        if (astar_isSolid(grid, nx, currentY) ||
+            astar_isSolid(grid, currentX, ny))
+          continue;
+        stepCost = ASTAR_DIAGONAL_COST;
+      }
+
+      if (astar->stamp[neighbor] != astar->generation)
+        astar_visit(astar, neighbor);
+      else if (astar->heapIndex[neighbor] == -1)
+        continue; // closed
+
+      f32 tentativeG = currentG + stepCost;
+      if (tentativeG >= astar->gScore[neighbor])
+        continue;
+
+      astar->cameFrom[neighbor] = current;
+      astar->gScore[neighbor] = tentativeG;
+      astar->fScore[neighbor] =
+          tentativeG + astar_heuristic(nx, ny, goalX, goalY, allowDiagonal);
+      if (astar->heapIndex[neighbor] < 0)
+      {
+        astar->heap[astar->heapCount] = neighbor;
+        astar->heapIndex[neighbor] = astar->heapCount;
+        astar->heapCount++;
+      }
+      astar_siftUp(astar, astar->heapIndex[neighbor]);
+    }
+  }
+
+  return 0;
+}
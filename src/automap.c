@@ -0,0 +1,108 @@
+#include "automap.h"
+#include "blit.h"
+#include "distfield.h"
+#include "graphics.h"
+#include <string.h>
+
+#define AUTOMAP_COLOR_FLOOR 0xFF1C1C1Cu
+#define AUTOMAP_COLOR_WALL 0xFFA8A8A8u
+#define AUTOMAP_COLOR_DOOR 0xFFD08A20u
+#define AUTOMAP_COLOR_PLAYER 0xFF40E040u
+
+u8 g_automapSeen[MAP_WIDTH][MAP_HEIGHT];
+
+static pixel_t g_image[AUTOMAP_HEIGHT * AUTOMAP_WIDTH];
+// tiles that ever changed at runtime, drawn as doors
+static u8 g_door[MAP_WIDTH][MAP_HEIGHT];
+static int g_enabled = 1;
+
+// tile x runs right and tile y runs down, like the editor grid
+static void automap_drawCell(int tileX, int tileY)
+{
+  u32 color;
+  if (g_door[tileX][tileY])
+    color = AUTOMAP_COLOR_DOOR;
+  else if (map_isSolid(tileX, tileY))
+    color = AUTOMAP_COLOR_WALL;
+  else
+    color = AUTOMAP_COLOR_FLOOR;
+
+  pixel_t value = pixel_fromARGB(color);
+  for (int row = 0; row < AUTOMAP_CELL; ++row)
+  {
+    pixel_t *dst =
+        g_image + (tileY * AUTOMAP_CELL + row) * AUTOMAP_WIDTH +
+        tileX * AUTOMAP_CELL;
+    g_blit.clear(dst, value, AUTOMAP_CELL);
+  }
+}
+
+void automap_noteSeen(int tileX, int tileY)
+{
+  g_automapSeen[tileX][tileY] = 1;
+  automap_drawCell(tileX, tileY);
+  // seen open tiles become skippable for the wall DDA
+  distfield_onTileChanged(tileX, tileY);
+}
+
+void automap_reset(void)
+{
+  memset(g_automapSeen, 0, sizeof(g_automapSeen));
+  memset(g_door, 0, sizeof(g_door));
+  // unseen cells stay transparent so the view shows through
+  g_blit.clear(g_image, pixel_fromARGB(0), AUTOMAP_WIDTH * AUTOMAP_HEIGHT);
+}
+
+void automap_onTileChanged(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return;
+  g_door[tileX][tileY] = 1;
+  if (g_automapSeen[tileX][tileY])
+    automap_drawCell(tileX, tileY);
+}
+
+void automap_setEnabled(int enabled)
+{
+  g_enabled = enabled ? 1 : 0;
+}
+
+int automap_isEnabled(void)
+{
+  return g_enabled;
+}
+
+static void automap_plot(pixel_t *buffer, int x, int y, pixel_t color)
+{
+  if (x < 0 || x >= RENDER_WIDTH || y < 0 || y >= RENDER_HEIGHT)
+    return;
+  buffer[y * RENDER_WIDTH + x] = color;
+}
+
+void automap_draw(pixel_t *buffer, f64 posX, f64 posY, f64 dirX, f64 dirY)
+{
+  if (!g_enabled || !buffer)
+    return;
+
+  const int originX = RENDER_WIDTH - AUTOMAP_WIDTH - AUTOMAP_MARGIN;
+  const int originY = AUTOMAP_MARGIN;
+  for (int row = 0; row < AUTOMAP_HEIGHT; ++row)
+  {
+    g_blit.copyKeyed(buffer + (originY + row) * RENDER_WIDTH + originX,
+                     g_image + row * AUTOMAP_WIDTH, AUTOMAP_WIDTH);
+  }
+
+  // the marker moves every frame, so it is never part of the cache
+  pixel_t player = pixel_fromARGB(AUTOMAP_COLOR_PLAYER);
+  int px = originX + (int)(posX * AUTOMAP_CELL);
+  int py = originY + (int)(posY * AUTOMAP_CELL);
+  for (int dy = -1; dy <= 1; ++dy)
+  {
+    for (int dx = -1; dx <= 1; ++dx)
+      automap_plot(buffer, px + dx, py + dy, player);
+  }
+  for (int i = 2; i <= AUTOMAP_CELL + 1; ++i)
+  {
+    automap_plot(buffer, px + (int)(dirX * i), py + (int)(dirY * i), player);
+  }
+}
@@ -0,0 +1,575 @@
+#include "blit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(PIXEL_RGB565)
+#define BLIT_X86 1
+#include <immintrin.h>
+#define BLIT_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* Scalar reference kernels, also the only ones in RGB565 builds */
+
+static void blit_clearScalar(pixel_t *dst, pixel_t value, int count)
+{
+  for (int i = 0; i < count; ++i)
+    dst[i] = value;
+}
+
+static void blit_copyKeyedScalar(pixel_t *dst, const pixel_t *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    if (pixel_isOpaque(src[i]))
+      dst[i] = src[i];
+  }
+}
+
+static inline u32 blit_blendChannel(u32 s, u32 d, u32 a)
+{
+  return (s * a + d * (255u - a) + 127u) / 255u;
+}
+
+static void blit_blendAlphaScalar(pixel_t *dst, const u32 *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    u32 s = src[i];
+    u32 a = s >> 24;
+    if (a == 0)
+      continue;
+
+    u32 d = pixel_toARGB(dst[i]);
+    u32 r = blit_blendChannel((s >> 16) & 0xFFu, (d >> 16) & 0xFFu, a);
+    u32 g = blit_blendChannel((s >> 8) & 0xFFu, (d >> 8) & 0xFFu, a);
+    u32 b = blit_blendChannel(s & 0xFFu, d & 0xFFu, a);
+    dst[i] = pixel_fromARGB(0xFF000000u | (r << 16) | (g << 8) | b);
+  }
+}
+
+static void blit_scaleNearestScalar(pixel_t *dst, const pixel_t *src,
+                                    int srcCount, int dstCount, int first,
+                                    int count)
+{
+  for (int i = 0; i < count; ++i)
+    dst[i] = src[(i64)(first + i) * srcCount / dstCount];
+}
+
+static void blit_shadeHalfScalar(pixel_t *dst, const pixel_t *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+#ifdef PIXEL_RGB565
+    dst[i] = (pixel_t)((src[i] >> 1) & 0x7BEFu);
+#else
+    dst[i] = ((src[i] >> 1) & 0x007F7F7Fu) | 0xFF000000u;
+#endif
+  }
+}
+
+static void blit_gradeLUTScalar(pixel_t *dst, const pixel_t *lut, int bits,
+                                int count)
+{
+#ifdef PIXEL_RGB565
+  (void)bits;
+  for (int i = 0; i < count; ++i)
+    dst[i] = lut[dst[i]];
+#else
+  const u32 shift = 8u - (u32)bits;
+  const u32 mask = (1u << bits) - 1u;
+  for (int i = 0; i < count; ++i)
+  {
+    u32 c = dst[i];
+    u32 r = (c >> (16u + shift)) & mask;
+    u32 g = (c >> (8u + shift)) & mask;
+    u32 b = (c >> shift) & mask;
+    dst[i] = lut[(b << (2 * bits)) | (g << bits) | r];
+  }
+#endif
+}
+
+static const BlitKernels g_blitScalar = {
+    BLIT_SCALAR,           blit_clearScalar,        blit_copyKeyedScalar,
+    blit_blendAlphaScalar, blit_scaleNearestScalar, blit_shadeHalfScalar,
+    blit_gradeLUTScalar,
+};
+
+BlitKernels g_blit = {
+    BLIT_SCALAR,           blit_clearScalar,        blit_copyKeyedScalar,
+    blit_blendAlphaScalar, blit_scaleNearestScalar, blit_shadeHalfScalar,
+    blit_gradeLUTScalar,
+};
+
+#ifdef BLIT_X86
+
+/* SSE2 */
+
+BLIT_TARGET("sse2")
+static void blit_clearSSE2(pixel_t *dst, pixel_t value, int count)
+{
+  const __m128i v = _mm_set1_epi32((int)value);
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_si128((__m128i *)(dst + i), v);
+  for (; i < count; ++i)
+    dst[i] = value;
+}
+
+BLIT_TARGET("sse2")
+static void blit_copyKeyedSSE2(pixel_t *dst, const pixel_t *src, int count)
+{
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  const __m128i zero = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // dst may be locked texture memory, so it is written but never read
+    __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, alpha), zero);
+    int keepBits = _mm_movemask_ps(_mm_castsi128_ps(keep));
+    if (keepBits == 0)
+      _mm_storeu_si128((__m128i *)(dst + i), s);
+    else if (keepBits != 0xF)
+    {
+      for (int lane = 0; lane < 4; ++lane)
+      {
+        if (!(keepBits & (1 << lane)))
+          dst[i + lane] = src[i + lane];
+      }
+    }
+  }
+  blit_copyKeyedScalar(dst + i, src + i, count - i);
+}
+
+/* Blends the 8 16-bit channel lanes of two pixels. floor(y / 255) is
+ * (y + 1 + (y >> 8)) >> 8 for every y the blend can produce. */
+BLIT_TARGET("sse2")
+static inline __m128i blit_blendLanesSSE2(__m128i s, __m128i d, __m128i a)
+{
+  const __m128i c255 = _mm_set1_epi16(255);
+  const __m128i c127 = _mm_set1_epi16(127);
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i y = _mm_add_epi16(
+      _mm_add_epi16(_mm_mullo_epi16(s, a),
+                    _mm_mullo_epi16(d, _mm_sub_epi16(c255, a))),
+      c127);
+  y = _mm_add_epi16(_mm_add_epi16(y, one), _mm_srli_epi16(y, 8));
+  return _mm_srli_epi16(y, 8);
+}
+
+// alpha of each 32-bit pixel copied into both of its 16-bit halves
+BLIT_TARGET("sse2")
+static inline __m128i blit_alphaPairsSSE2(__m128i s)
+{
+  __m128i a = _mm_srli_epi32(s, 24);
+  return _mm_or_si128(a, _mm_slli_epi32(a, 16));
+}
+
+BLIT_TARGET("sse2")
+static void blit_blendAlphaSSE2(pixel_t *dst, const u32 *src, int count)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i a = blit_alphaPairsSSE2(s);
+    __m128i lo = blit_blendLanesSSE2(_mm_unpacklo_epi8(s, zero),
+                                     _mm_unpacklo_epi8(d, zero),
+                                     _mm_unpacklo_epi32(a, a));
+    __m128i hi = blit_blendLanesSSE2(_mm_unpackhi_epi8(s, zero),
+                                     _mm_unpackhi_epi8(d, zero),
+                                     _mm_unpackhi_epi32(a, a));
+    __m128i out = _mm_or_si128(_mm_packus_epi16(lo, hi), alpha);
+    __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, alpha), zero);
+    out = _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, out));
+    _mm_storeu_si128((__m128i *)(dst + i), out);
+  }
+  blit_blendAlphaScalar(dst + i, src + i, count - i);
+}
+
+BLIT_TARGET("sse2")
+static void blit_scaleNearestSSE2(pixel_t *dst, const pixel_t *src,
+                                  int srcCount, int dstCount, int first,
+                                  int count)
+{
+  // the quotient of two small integers is exact in double precision
+  const __m128d scale = _mm_set1_pd((double)dstCount);
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    int x = first + i;
+    __m128d n0 = _mm_set_pd((double)(x + 1) * srcCount, (double)x * srcCount);
+    __m128d n1 =
+        _mm_set_pd((double)(x + 3) * srcCount, (double)(x + 2) * srcCount);
+    __m128i q0 = _mm_cvttpd_epi32(_mm_div_pd(n0, scale));
+    __m128i q1 = _mm_cvttpd_epi32(_mm_div_pd(n1, scale));
+    __m128i q = _mm_unpacklo_epi64(q0, q1);
+    i32 index[4];
+    _mm_storeu_si128((__m128i *)index, q);
+    _mm_storeu_si128((__m128i *)(dst + i),
+                     _mm_setr_epi32((int)src[index[0]], (int)src[index[1]],
+                                    (int)src[index[2]], (int)src[index[3]]));
+  }
+  blit_scaleNearestScalar(dst + i, src, srcCount, dstCount, first + i,
+                          count - i);
+}
+
+BLIT_TARGET("sse2")
+static void blit_shadeHalfSSE2(pixel_t *dst, const pixel_t *src, int count)
+{
+  const __m128i mask = _mm_set1_epi32(0x007F7F7F);
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    v = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 1), mask), alpha);
+    _mm_storeu_si128((__m128i *)(dst + i), v);
+  }
+  blit_shadeHalfScalar(dst + i, src + i, count - i);
+}
+
+// no gather before AVX2: indices in a vector, four plain loads
+BLIT_TARGET("sse2")
+static void blit_gradeLUTSSE2(pixel_t *dst, const pixel_t *lut, int bits,
+                              int count)
+{
+  const __m128i mask = _mm_set1_epi32((1 << bits) - 1);
+  const __m128i shiftR = _mm_cvtsi32_si128(16 + 8 - bits);
+  const __m128i shiftG = _mm_cvtsi32_si128(8 + 8 - bits);
+  const __m128i shiftB = _mm_cvtsi32_si128(8 - bits);
+  const __m128i placeG = _mm_cvtsi32_si128(bits);
+  const __m128i placeB = _mm_cvtsi32_si128(2 * bits);
+  u32 index[4];
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i r = _mm_and_si128(_mm_srl_epi32(c, shiftR), mask);
+    __m128i g = _mm_and_si128(_mm_srl_epi32(c, shiftG), mask);
+    __m128i b = _mm_and_si128(_mm_srl_epi32(c, shiftB), mask);
+    _mm_storeu_si128((__m128i *)index,
+                     _mm_or_si128(_mm_or_si128(_mm_sll_epi32(b, placeB),
+                                               _mm_sll_epi32(g, placeG)),
+                                  r));
+    dst[i] = lut[index[0]];
+    dst[i + 1] = lut[index[1]];
+    dst[i + 2] = lut[index[2]];
+    dst[i + 3] = lut[index[3]];
+  }
+  blit_gradeLUTScalar(dst + i, lut, bits, count - i);
+}
+
+/* SSE4.1: blendv selects and 32-bit multiplies */
+
+BLIT_TARGET("sse4.1")
+static void blit_blendAlphaSSE41(pixel_t *dst, const u32 *src, int count)
+{
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  const __m128i zero = _mm_setzero_si128();
+  // copies each pixel's alpha byte into all four of its 16-bit lanes
+  const __m128i spreadLo =
+      _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+  const __m128i spreadHi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15,
+                                         -1, 15, -1, 15, -1, 15, -1);
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i lo = blit_blendLanesSSE2(_mm_cvtepu8_epi16(s),
+                                     _mm_cvtepu8_epi16(d),
+                                     _mm_shuffle_epi8(s, spreadLo));
+    __m128i hi = blit_blendLanesSSE2(_mm_unpackhi_epi8(s, zero),
+                                     _mm_unpackhi_epi8(d, zero),
+                                     _mm_shuffle_epi8(s, spreadHi));
+    __m128i out = _mm_or_si128(_mm_packus_epi16(lo, hi), alpha);
+    __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, alpha), zero);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_blendv_epi8(out, d, keep));
+  }
+  blit_blendAlphaScalar(dst + i, src + i, count - i);
+}
+
+// exact n / divisor for n < 2^24: float estimate, then a +-1 fix up
+BLIT_TARGET("sse4.1")
+static inline __m128i blit_divideSSE41(__m128i n, __m128i divisor,
+                                       __m128 divisorF)
+{
+  const __m128i one = _mm_set1_epi32(1);
+  __m128i q = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(n), divisorF));
+  __m128i over = _mm_cmpgt_epi32(_mm_mullo_epi32(q, divisor), n);
+  q = _mm_add_epi32(q, over); // -1 where q * divisor > n
+  __m128i next = _mm_mullo_epi32(_mm_add_epi32(q, one), divisor);
+  __m128i under = _mm_cmpgt_epi32(next, n);
+  return _mm_sub_epi32(_mm_add_epi32(q, one), _mm_and_si128(under, one));
+}
+
+BLIT_TARGET("sse4.1")
+static void blit_scaleNearestSSE41(pixel_t *dst, const pixel_t *src,
+                                   int srcCount, int dstCount, int first,
+                                   int count)
+{
+  if ((i64)(first + count) * srcCount >= (1 << 24))
+  {
+    blit_scaleNearestSSE2(dst, src, srcCount, dstCount, first, count);
+    return;
+  }
+
+  const __m128i step = _mm_set1_epi32(4 * srcCount);
+  const __m128i divisor = _mm_set1_epi32(dstCount);
+  const __m128 divisorF = _mm_set1_ps((float)dstCount);
+  __m128i n = _mm_mullo_epi32(
+      _mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3)),
+      _mm_set1_epi32(srcCount));
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i q = blit_divideSSE41(n, divisor, divisorF);
+    _mm_storeu_si128((__m128i *)(dst + i),
+                     _mm_setr_epi32((int)src[_mm_extract_epi32(q, 0)],
+                                    (int)src[_mm_extract_epi32(q, 1)],
+                                    (int)src[_mm_extract_epi32(q, 2)],
+                                    (int)src[_mm_extract_epi32(q, 3)]));
+    n = _mm_add_epi32(n, step);
+  }
+  blit_scaleNearestScalar(dst + i, src, srcCount, dstCount, first + i,
+                          count - i);
+}
+
+/* AVX2: eight pixels per step, hardware gather for the resample */
+
+BLIT_TARGET("avx2")
+static void blit_clearAVX2(pixel_t *dst, pixel_t value, int count)
+{
+  const __m256i v = _mm256_set1_epi32((int)value);
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  blit_clearScalar(dst + i, value, count - i);
+}
+
+BLIT_TARGET("avx2")
+static void blit_copyKeyedAVX2(pixel_t *dst, const pixel_t *src, int count)
+{
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    // a masked store leaves the keyed lanes alone without reading dst
+    __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha), zero);
+    _mm256_maskstore_epi32((int *)(dst + i), _mm256_xor_si256(keep, ones), s);
+  }
+  blit_copyKeyedScalar(dst + i, src + i, count - i);
+}
+
+BLIT_TARGET("avx2")
+static inline __m256i blit_blendLanesAVX2(__m256i s, __m256i d, __m256i a)
+{
+  const __m256i c255 = _mm256_set1_epi16(255);
+  const __m256i c127 = _mm256_set1_epi16(127);
+  const __m256i one = _mm256_set1_epi16(1);
+  __m256i y = _mm256_add_epi16(
+      _mm256_add_epi16(_mm256_mullo_epi16(s, a),
+                       _mm256_mullo_epi16(d, _mm256_sub_epi16(c255, a))),
+      c127);
+  y = _mm256_add_epi16(_mm256_add_epi16(y, one), _mm256_srli_epi16(y, 8));
+  return _mm256_srli_epi16(y, 8);
+}
+
+BLIT_TARGET("avx2")
+static void blit_blendAlphaAVX2(pixel_t *dst, const u32 *src, int count)
+{
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i spreadLo = _mm256_setr_epi8(
+      3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1, 3, -1, 3, -1, 3,
+      -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+  const __m256i spreadHi = _mm256_setr_epi8(
+      11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1, 11, -1,
+      11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    // unpacks work per 128-bit lane, packus undoes them the same way
+    __m256i lo = blit_blendLanesAVX2(_mm256_unpacklo_epi8(s, zero),
+                                     _mm256_unpacklo_epi8(d, zero),
+                                     _mm256_shuffle_epi8(s, spreadLo));
+    __m256i hi = blit_blendLanesAVX2(_mm256_unpackhi_epi8(s, zero),
+                                     _mm256_unpackhi_epi8(d, zero),
+                                     _mm256_shuffle_epi8(s, spreadHi));
+    __m256i out = _mm256_or_si256(_mm256_packus_epi16(lo, hi), alpha);
+    __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha), zero);
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_blendv_epi8(out, d, keep));
+  }
+  blit_blendAlphaScalar(dst + i, src + i, count - i);
+}
+
+BLIT_TARGET("avx2")
+static void blit_scaleNearestAVX2(pixel_t *dst, const pixel_t *src,
+                                  int srcCount, int dstCount, int first,
+                                  int count)
+{
+  if ((i64)(first + count) * srcCount >= (1 << 24))
+  {
+    blit_scaleNearestSSE2(dst, src, srcCount, dstCount, first, count);
+    return;
+  }
+
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i step = _mm256_set1_epi32(8 * srcCount);
+  const __m256i divisor = _mm256_set1_epi32(dstCount);
+  const __m256 divisorF = _mm256_set1_ps((float)dstCount);
+  __m256i n = _mm256_mullo_epi32(
+      _mm256_add_epi32(_mm256_set1_epi32(first),
+                       _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+      _mm256_set1_epi32(srcCount));
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i q =
+        _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(n), divisorF));
+    __m256i over = _mm256_cmpgt_epi32(_mm256_mullo_epi32(q, divisor), n);
+    q = _mm256_add_epi32(q, over);
+    __m256i next = _mm256_mullo_epi32(_mm256_add_epi32(q, one), divisor);
+    __m256i under = _mm256_cmpgt_epi32(next, n);
+    q = _mm256_sub_epi32(_mm256_add_epi32(q, one), _mm256_and_si256(under, one));
+    _mm256_storeu_si256((__m256i *)(dst + i),
+                        _mm256_i32gather_epi32((const int *)src, q, 4));
+    n = _mm256_add_epi32(n, step);
+  }
+  blit_scaleNearestScalar(dst + i, src, srcCount, dstCount, first + i,
+                          count - i);
+}
+
+BLIT_TARGET("avx2")
+static void blit_shadeHalfAVX2(pixel_t *dst, const pixel_t *src, int count)
+{
+  const __m256i mask = _mm256_set1_epi32(0x007F7F7F);
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    v = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(v, 1), mask),
+                        alpha);
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  }
+  blit_shadeHalfScalar(dst + i, src + i, count - i);
+}
+
+BLIT_TARGET("avx2")
+static void blit_gradeLUTAVX2(pixel_t *dst, const pixel_t *lut, int bits,
+                              int count)
+{
+  const __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+  const __m128i shiftR = _mm_cvtsi32_si128(16 + 8 - bits);
+  const __m128i shiftG = _mm_cvtsi32_si128(8 + 8 - bits);
+  const __m128i shiftB = _mm_cvtsi32_si128(8 - bits);
+  const __m128i placeG = _mm_cvtsi32_si128(bits);
+  const __m128i placeB = _mm_cvtsi32_si128(2 * bits);
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i r = _mm256_and_si256(_mm256_srl_epi32(c, shiftR), mask);
+    __m256i g = _mm256_and_si256(_mm256_srl_epi32(c, shiftG), mask);
+    __m256i b = _mm256_and_si256(_mm256_srl_epi32(c, shiftB), mask);
+    __m256i index = _mm256_or_si256(
+        _mm256_or_si256(_mm256_sll_epi32(b, placeB),
+                        _mm256_sll_epi32(g, placeG)),
+        r);
+    __m256i v = _mm256_i32gather_epi32((const int *)lut, index, 4);
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  }
+  blit_gradeLUTScalar(dst + i, lut, bits, count - i);
+}
+
+static const BlitKernels g_blitSSE2 = {
+    BLIT_SSE2,           blit_clearSSE2,        blit_copyKeyedSSE2,
+    blit_blendAlphaSSE2, blit_scaleNearestSSE2, blit_shadeHalfSSE2,
+    blit_gradeLUTSSE2,
+};
+
+// clear, copy, shade and grade gain nothing from SSE4.1, reuse the SSE2 ones
+static const BlitKernels g_blitSSE41 = {
+    BLIT_SSE41,           blit_clearSSE2,         blit_copyKeyedSSE2,
+    blit_blendAlphaSSE41, blit_scaleNearestSSE41, blit_shadeHalfSSE2,
+    blit_gradeLUTSSE2,
+};
+
+static const BlitKernels g_blitAVX2 = {
+    BLIT_AVX2,           blit_clearAVX2,        blit_copyKeyedAVX2,
+    blit_blendAlphaAVX2, blit_scaleNearestAVX2, blit_shadeHalfAVX2,
+    blit_gradeLUTAVX2,
+};
+
+#endif
+
+static const char *g_blitLevelNames[BLIT_LEVELS] = {"scalar", "sse2",
+                                                    "sse4.1", "avx2"};
+
+const BlitKernels *blit_getKernels(BlitLevel level)
+{
+  switch (level)
+  {
+  case BLIT_SCALAR:
+    return &g_blitScalar;
+#ifdef BLIT_X86
+  case BLIT_SSE2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") ? &g_blitSSE2 : NULL;
+  case BLIT_SSE41:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1") ? &g_blitSSE41 : NULL;
+  case BLIT_AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &g_blitAVX2 : NULL;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+const char *blit_levelName(BlitLevel level)
+{
+  if (level < 0 || level >= BLIT_LEVELS)
+    return "?";
+  return g_blitLevelNames[level];
+}
+
+void blit_init(void)
+{
+  int cap = BLIT_LEVELS - 1;
+  const char *override = getenv("RAYCASTER_SIMD");
+  if (override)
+  {
+    for (int i = 0; i < BLIT_LEVELS; ++i)
+    {
+      if (strcmp(override, g_blitLevelNames[i]) == 0)
+        cap = i;
+    }
+  }
+
+  for (int level = cap; level >= BLIT_SCALAR; --level)
+  {
+    const BlitKernels *kernels = blit_getKernels((BlitLevel)level);
+    if (kernels)
+    {
+      g_blit = *kernels;
+      break;
+    }
+  }
+
+  printf("\033[32m[SIMD] Blit kernels: %s\033[0m\n",
+         g_blitLevelNames[g_blit.level]);
+}
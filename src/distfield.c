@@ -0,0 +1,108 @@
+#include "distfield.h"
+#include "automap.h"
+
+u8 g_distField[MAP_WIDTH][MAP_HEIGHT];
+
+// distance along the row to the nearest blocker, the first pass of the field
+static u8 g_rowDist[MAP_WIDTH][MAP_HEIGHT];
+
+static int g_dirtyMinX = MAP_WIDTH;
+static int g_dirtyMinY = MAP_HEIGHT;
+static int g_dirtyMaxX = -1;
+static int g_dirtyMaxY = -1;
+
+// the row pass walks along x, so it reads the row major bitmap
+static inline int distfield_isBlocker(int x, int y)
+{
+  if (x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT)
+    return 1;
+  return map_isSolidInRow(x, y) || !g_automapSeen[x][y];
+}
+
+static void distfield_computeRows(int minX, int maxX, int minY, int maxY)
+{
+  for (int x = minX; x <= maxX; ++x)
+  {
+    for (int y = minY; y <= maxY; ++y)
+    {
+      int d = 0;
+      while (d < DISTFIELD_MAX && !distfield_isBlocker(x - d, y) &&
+             !distfield_isBlocker(x + d, y))
+        ++d;
+      g_rowDist[x][y] = (u8)d;
+    }
+  }
+}
+
+// second pass: the nearest blocker over the rows within reach
+static void distfield_computeField(int minX, int maxX, int minY, int maxY)
+{
+  for (int x = minX; x <= maxX; ++x)
+  {
+    for (int y = minY; y <= maxY; ++y)
+    {
+      int best = g_rowDist[x][y];
+      for (int dy = 1; dy < best; ++dy)
+      {
+        // rows past the map edge are all blockers
+        int up = (y - dy >= 0) ? g_rowDist[x][y - dy] : 0;
+        int down = (y + dy < MAP_HEIGHT) ? g_rowDist[x][y + dy] : 0;
+        int row = (up < down) ? up : down;
+        int reach = (row > dy) ? row : dy;
+        if (reach < best)
+          best = reach;
+      }
+      g_distField[x][y] = (u8)best;
+    }
+  }
+}
+
+static inline int distfield_clamp(int v, int lo, int hi)
+{
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void distfield_build(void)
+{
+  distfield_computeRows(0, MAP_WIDTH - 1, 0, MAP_HEIGHT - 1);
+  distfield_computeField(0, MAP_WIDTH - 1, 0, MAP_HEIGHT - 1);
+  g_dirtyMinX = MAP_WIDTH;
+  g_dirtyMinY = MAP_HEIGHT;
+  g_dirtyMaxX = -1;
+  g_dirtyMaxY = -1;
+}
+
+void distfield_onTileChanged(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return;
+  if (tileX < g_dirtyMinX)
+    g_dirtyMinX = tileX;
+  if (tileX > g_dirtyMaxX)
+    g_dirtyMaxX = tileX;
+  if (tileY < g_dirtyMinY)
+    g_dirtyMinY = tileY;
+  if (tileY > g_dirtyMaxY)
+    g_dirtyMaxY = tileY;
+}
+
+void distfield_update(void)
+{
+  if (g_dirtyMaxX < 0)
+    return;
+
+  // a changed row value reaches DISTFIELD_MAX tiles along the row, the
+  // field another DISTFIELD_MAX rows across
+  int rowMinX = distfield_clamp(g_dirtyMinX - DISTFIELD_MAX, 0, MAP_WIDTH - 1);
+  int rowMaxX = distfield_clamp(g_dirtyMaxX + DISTFIELD_MAX, 0, MAP_WIDTH - 1);
+  distfield_computeRows(rowMinX, rowMaxX, g_dirtyMinY, g_dirtyMaxY);
+
+  int minY = distfield_clamp(g_dirtyMinY - DISTFIELD_MAX, 0, MAP_HEIGHT - 1);
+  int maxY = distfield_clamp(g_dirtyMaxY + DISTFIELD_MAX, 0, MAP_HEIGHT - 1);
+  distfield_computeField(rowMinX, rowMaxX, minY, maxY);
+
+  g_dirtyMinX = MAP_WIDTH;
+  g_dirtyMinY = MAP_HEIGHT;
+  g_dirtyMaxX = -1;
+  g_dirtyMaxY = -1;
+}
@@ -0,0 +1,215 @@
+#include "dynlight.h"
+#include "lightmap.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct
+{
+  int active;
+  int generation;
+  f32 x;
+  f32 y;
+  f32 radius;
+  f32 intensity;
+  f32 lifetime;
+  f32 age;
+  int originX; // top left tile of the footprint the light was applied to
+  int originY;
+  u8 contribution[DYNLIGHT_FOOTPRINT * DYNLIGHT_FOOTPRINT];
+} DynLight;
+
+u8 g_dynLightLevel[MAP_WIDTH][MAP_HEIGHT];
+
+static u16 g_dynLightSum[MAP_WIDTH][MAP_HEIGHT];
+static DynLight g_dynLights[DYNLIGHT_MAX];
+static int g_dynLightCount = 0;
+static int g_dynLightCap = DYNLIGHT_DEFAULT_CAP;
+
+static void dynlight_storeLevel(int x, int y)
+{
+  u16 sum = g_dynLightSum[x][y];
+  g_dynLightLevel[x][y] =
+      (u8)(sum > LIGHT_LEVELS - 1 ? LIGHT_LEVELS - 1 : sum);
+}
+
+// subtracts exactly what dynlight_apply added, so the grid never drifts
+static void dynlight_unapply(DynLight *light)
+{
+  for (int j = 0; j < DYNLIGHT_FOOTPRINT; ++j)
+  {
+    for (int i = 0; i < DYNLIGHT_FOOTPRINT; ++i)
+    {
+      u8 value = light->contribution[j * DYNLIGHT_FOOTPRINT + i];
+      if (value == 0)
+        continue;
+      int x = light->originX + i;
+      int y = light->originY + j;
+      g_dynLightSum[x][y] -= value;
+      dynlight_storeLevel(x, y);
+    }
+  }
+  memset(light->contribution, 0, sizeof(light->contribution));
+}
+
+static void dynlight_apply(DynLight *light)
+{
+  f32 fade = 1.0f;
+  if (light->lifetime > 0.0f)
+    fade = 1.0f - light->age / light->lifetime;
+
+  light->originX = (int)light->x - DYNLIGHT_MAX_RADIUS;
+  light->originY = (int)light->y - DYNLIGHT_MAX_RADIUS;
+
+  for (int j = 0; j < DYNLIGHT_FOOTPRINT; ++j)
+  {
+    int y = light->originY + j;
+    if (y < 0 || y >= MAP_HEIGHT)
+      continue;
+    for (int i = 0; i < DYNLIGHT_FOOTPRINT; ++i)
+    {
+      int x = light->originX + i;
+      if (x < 0 || x >= MAP_WIDTH || map_isSolid(x, y))
+        continue;
+
+      f32 dx = ((f32)x + 0.5f) - light->x;
+      f32 dy = ((f32)y + 0.5f) - light->y;
+      f32 dist = sqrtf(dx * dx + dy * dy);
+      if (dist >= light->radius)
+        continue;
+      if (!lightmap_traceVisible(light->x, light->y, (f32)x + 0.5f,
+                                 (f32)y + 0.5f))
+        continue;
+
+      f32 falloff = 1.0f - dist / light->radius;
+      f32 value = light->intensity * fade * falloff * falloff + 0.5f;
+      if (value < 1.0f)
+        continue;
+      u8 amount = (u8)(value > 255.0f ? 255.0f : value);
+      light->contribution[j * DYNLIGHT_FOOTPRINT + i] = amount;
+      g_dynLightSum[x][y] += amount;
+      dynlight_storeLevel(x, y);
+    }
+  }
+}
+
+static DynLight *dynlight_resolve(int handle)
+{
+  if (handle < 0)
+    return NULL;
+  int index = handle & 0xFF;
+  if (index >= DYNLIGHT_MAX)
+    return NULL;
+  DynLight *light = &g_dynLights[index];
+  if (!light->active || light->generation != (handle >> 8))
+    return NULL;
+  return light;
+}
+
+static void dynlight_release(DynLight *light)
+{
+  dynlight_unapply(light);
+  light->active = 0;
+  light->generation = (light->generation + 1) & 0x7FFF;
+  g_dynLightCount--;
+}
+
+void dynlight_reset(void)
+{
+  for (int i = 0; i < DYNLIGHT_MAX; ++i)
+  {
+    g_dynLights[i].active = 0;
+    memset(g_dynLights[i].contribution, 0,
+           sizeof(g_dynLights[i].contribution));
+  }
+  g_dynLightCount = 0;
+  memset(g_dynLightSum, 0, sizeof(g_dynLightSum));
+  memset(g_dynLightLevel, 0, sizeof(g_dynLightLevel));
+}
+
+void dynlight_setCap(int cap)
+{
+  if (cap < 0)
+    cap = 0;
+  if (cap > DYNLIGHT_MAX)
+    cap = DYNLIGHT_MAX;
+  g_dynLightCap = cap;
+}
+
+int dynlight_getCap(void)
+{
+  return g_dynLightCap;
+}
+
+int dynlight_getCount(void)
+{
+  return g_dynLightCount;
+}
+
+int dynlight_spawn(f32 x, f32 y, f32 radius, f32 intensity, f32 lifetime)
+{
+  if (g_dynLightCount >= g_dynLightCap || radius <= 0.0f || intensity <= 0.0f)
+    return -1;
+
+  for (int i = 0; i < DYNLIGHT_MAX; ++i)
+  {
+    DynLight *light = &g_dynLights[i];
+    if (light->active)
+      continue;
+
+    light->active = 1;
+    light->x = x;
+    light->y = y;
+    light->radius = radius > (f32)DYNLIGHT_MAX_RADIUS ? (f32)DYNLIGHT_MAX_RADIUS
+                                                      : radius;
+    light->intensity = intensity;
+    light->lifetime = lifetime;
+    light->age = 0.0f;
+    g_dynLightCount++;
+    dynlight_apply(light);
+    return (light->generation << 8) | i;
+  }
+  return -1;
+}
+
+void dynlight_move(int handle, f32 x, f32 y)
+{
+  DynLight *light = dynlight_resolve(handle);
+  if (!light || (light->x == x && light->y == y))
+    return;
+
+  dynlight_unapply(light);
+  light->x = x;
+  light->y = y;
+  dynlight_apply(light);
+}
+
+void dynlight_remove(int handle)
+{
+  DynLight *light = dynlight_resolve(handle);
+  if (light)
+    dynlight_release(light);
+}
+
+void dynlight_update(f64 deltaTime)
+{
+  if (g_dynLightCount == 0)
+    return;
+
+  for (int i = 0; i < DYNLIGHT_MAX; ++i)
+  {
+    DynLight *light = &g_dynLights[i];
+    if (!light->active || light->lifetime <= 0.0f)
+      continue;
+
+    light->age += (f32)deltaTime;
+    if (light->age >= light->lifetime)
+    {
+      dynlight_release(light);
+      continue;
+    }
+
+    // fading lights only touch their own footprint
+    dynlight_unapply(light);
+    dynlight_apply(light);
+  }
+}
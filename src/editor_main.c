@@ -665,11 +665,6 @@ static int editor_totalEntityCount(void)
          g_wallTextCount;
 }
 
-static bool editor_hasSpriteCapacity(void)
-{
-  return editor_totalEntityCount() < NUM_SPRITES;
-}
-
 static int editor_guessDecalFacing(int tileX, int tileY)
 {
   static const int lookupOrder[4][2] = {
@@ -763,11 +758,6 @@ static EditorDecoration *editor_addDecoration(float x, float y, int typeIndex)
 {
   if (typeIndex < 0 || typeIndex >= g_decorationTypeCount)
     return NULL;
-  if (!editor_hasSpriteCapacity())
-  {
-    editor_setWarningStatus("Sprite limit reached (%d).", NUM_SPRITES);
-    return NULL;
-  }
   EditorDecoration decoration;
   decoration.x = x;
   decoration.y = y;
@@ -783,11 +773,6 @@ static EditorPickup *editor_addPickup(float x, float y, int typeIndex)
 {
   if (typeIndex < 0 || typeIndex >= g_pickupTypeCount)
     return NULL;
-  if (!editor_hasSpriteCapacity())
-  {
-    editor_setWarningStatus("Sprite limit reached (%d).", NUM_SPRITES);
-    return NULL;
-  }
   EditorPickup pickup;
   pickup.x = x;
   pickup.y = y;
@@ -803,11 +788,6 @@ static EditorDecal *editor_addDecal(float x, float y, int typeIndex)
 {
   if (typeIndex < 0 || typeIndex >= g_decalTypeCount)
     return NULL;
-  if (!editor_hasSpriteCapacity())
-  {
-    editor_setWarningStatus("Sprite limit reached (%d).", NUM_SPRITES);
-    return NULL;
-  }
   int tileX = (int)floorf(x);
   int tileY = (int)floorf(y);
   if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
@@ -955,11 +935,6 @@ static EditorEnemy *editor_pushEnemy(const EditorEnemy *source)
 
 static EditorEnemy *editor_addEnemy(float x, float y, const EnemyType *type)
 {
-  if (!editor_hasSpriteCapacity())
-  {
-    editor_setWarningStatus("Sprite limit reached (%d).", NUM_SPRITES);
-    return NULL;
-  }
   EditorEnemy enemy;
   enemy.x = x;
   enemy.y = y;
@@ -1382,7 +1357,6 @@ static int editor_loadEntities(void)
   g_playerSpawnDirDegrees = g_defaultPlayerSpawnDirDegrees;
 
   int status = 0;
-  bool limitWarned = false;
 
   char *decorationsArray = editor_extractArray(json, "decorations");
   if (decorationsArray)
@@ -1425,18 +1399,6 @@ static int editor_loadEntities(void)
         typeIndex = 0;
       }
 
-      if (!editor_hasSpriteCapacity())
-      {
-        if (!limitWarned)
-        {
-          editor_setWarningStatus("Sprite limit reached (%d); extra entities ignored.",
-                                  NUM_SPRITES);
-          limitWarned = true;
-        }
-        cursor = objEnd + 1;
-        continue;
-      }
-
       EditorDecoration decoration;
       decoration.x = (float)valueX;
       decoration.y = (float)valueY;
@@ -1493,18 +1455,6 @@ static int editor_loadEntities(void)
         typeIndex = 0;
       }
 
-      if (!editor_hasSpriteCapacity())
-      {
-        if (!limitWarned)
-        {
-          editor_setWarningStatus("Sprite limit reached (%d); extra entities ignored.",
-                                  NUM_SPRITES);
-          limitWarned = true;
-        }
-        cursor = objEnd + 1;
-        continue;
-      }
-
       EditorPickup pickup;
       pickup.x = (float)valueX;
       pickup.y = (float)valueY;
@@ -1567,18 +1517,6 @@ static int editor_loadEntities(void)
         continue;
       }
 
-      if (!editor_hasSpriteCapacity())
-      {
-        if (!limitWarned)
-        {
-          editor_setWarningStatus("Sprite limit reached (%d); extra entities ignored.",
-                                  NUM_SPRITES);
-          limitWarned = true;
-        }
-        cursor = objEnd + 1;
-        continue;
-      }
-
       char facingName[16];
       int facingIndex =
           editor_jsonGetString(objStart, objEnd, "facing", facingName,
@@ -1742,18 +1680,6 @@ static int editor_loadEntities(void)
       if (!objEnd)
         break;
 
-      if (!editor_hasSpriteCapacity())
-      {
-        if (!limitWarned)
-        {
-          editor_setWarningStatus("Sprite limit reached (%d); extra entities ignored.",
-                                  NUM_SPRITES);
-          limitWarned = true;
-        }
-        cursor = objEnd + 1;
-        continue;
-      }
-
       EditorEnemy enemy;
       enemy.scale = g_enemyTypes[0].defaultScale;
       enemy.health = g_enemyTypes[0].defaultHealth;
@@ -1821,8 +1747,6 @@ static int editor_loadEntities(void)
     g_ceilingTextureSelection = g_ceilingTextureId;
   }
 
-  if (limitWarned && status == 0)
-    status = 1;
   g_entitiesDirty = false;
   free(json);
   return status;
@@ -2109,6 +2033,7 @@ static void editor_syncTilesToEngine(void)
     for (int y = 0; y < MAP_HEIGHT; ++y)
       worldMap[x][y] = g_levelTiles[x][y];
   }
+  map_syncSolidity();
 }
 
 static void editor_saveMap(void)
@@ -2777,9 +2702,7 @@ int main(int argc, char **argv)
       igSeparator();
 
       int totalEntities = editor_totalEntityCount();
-      igText("Sprite slots used: %d / %d", totalEntities, NUM_SPRITES);
-      if (totalEntities >= NUM_SPRITES)
-        igTextColored((ImVec4){0.9f, 0.4f, 0.2f, 1.0f}, "Sprite capacity reached - remove entries before adding more.");
+      igText("Entities: %d", totalEntities);
       igSeparator();
       igText("Player Spawn");
       igText("Current: (%.2f, %.2f)", g_playerSpawnPos.x, g_playerSpawnPos.y);
@@ -1,15 +1,72 @@
 #include "enemies.h"
+#include "astar.h"
+#include "blit.h"
+#include "dynlight.h"
 #include "engine.h"
+#include "entities.h"
+#include "flowfield.h"
 #include "map.h"
+#include "pvs.h"
+#include "rayquery.h"
 #include "sprites.h"
+#include "weapons.h"
+#include "threads.h"
 #include <float.h>
 #include <stdbool.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__))
+#define HITSCAN_X86 1
+#include <immintrin.h>
+#define HITSCAN_TARGET(isa) __attribute__((target(isa)))
+#endif
 
 static const f64 SPRITE_BASE_HIT_RADIUS = 0.30;
 static const double ENEMY_MOVE_SPEED = 1.6;
+static const f32 MUZZLE_FLASH_RADIUS = 3.5f;
+static const f32 MUZZLE_FLASH_INTENSITY = 24.0f;
+static const f32 MUZZLE_FLASH_LIFETIME = 0.08f;
+static const f32 IMPACT_FLASH_RADIUS = 1.5f;
+static const f32 IMPACT_FLASH_INTENSITY = 16.0f;
+static const f32 IMPACT_FLASH_LIFETIME = 0.12f;
+
+#define HITSCAN_MAX_PELLETS 32
+
+/* AI level of detail: enemies near or in sight of the player think every
+ * frame, the rest every few frames on a round robin slot and just keep
+ * walking toward their last picked tile in between. */
+#define AI_NEAR_DISTANCE 8.0
+#define AI_MID_DISTANCE 16.0
+/* Mid and far thinks per frame, about 1 ms worth. A count instead of a
+ * clock keeps the update deterministic: same input, same frame. */
+#define AI_THINK_QUOTA 48
+#define AI_BATCH 32 // sight lines per batched ray query
+
+/* Crowd separation: enemies whose bodies overlap push apart a little every
+ * frame instead of stacking on the same tile centre. Each enemy looks at a
+ * bounded number of grid entries around it, so the pass stays linear in
+ * the enemy count however dense the crowd gets. */
+#define ENEMY_BODY_RADIUS 0.25      // per unit of scale, as for the player
+#define ENEMY_SEPARATION_SPEED 1.2  // tiles per second at full overlap
+#define ENEMY_SEPARATION_NEIGHBOURS 4
+#define ENEMY_SEPARATION_SCAN 32    // grid entries looked at, at most
+
+typedef enum
+{
+  AI_TIER_NEAR = 0,
+  AI_TIER_MID,
+  AI_TIER_FAR,
+  AI_TIER_COUNT
+} AITier;
 
-#define ASTAR_MAX_NODES (MAP_WIDTH * MAP_HEIGHT)
+static const u32 g_tierPeriod[AI_TIER_COUNT] = {1, 4, 16};
+
+// cached A* paths are cut to this many tiles and re-planned at the end
+#define ENEMY_PATH_MAX 64
 
 typedef struct
 {
@@ -17,344 +74,941 @@ typedef struct
   int y;
 } GridCoord;
 
-static inline int coord_index(int x, int y)
+/* Per-enemy state is indexed by entity slot and grown with the store. A
+ * slot remembers the generation it was set up for, so an enemy spawned into
+ * a reused slot starts from a clean state. */
+static i32 g_slotCapacity = 0;
+static u32 *g_slotGeneration;
+// tile each enemy last saw the player on, chased until reached
+static GridCoord *g_lastSeen;
+// tile the enemy is walking to, picked at its last think
+static GridCoord *g_walkTo;
+static bool *g_hasLastSeen;
+// result of the last think: saw the player, has a tile to walk to
+static bool *g_sees;
+static bool *g_moving;
+// pushed out of a frame by the quota, thinks first next frame
+static bool *g_overdue;
+static u32 g_aiFrame = 0;
+
+/* The update runs in phases. The read phase thinks and computes where
+ * every enemy wants to be from the positions as they were at the start of
+ * the frame, spread over the worker threads; each enemy only writes its own
+ * slots. The separation phase nudges those intents apart the same way, and
+ * the commit phase then applies the moves in a fixed order. */
+static bool *g_thinkNow;
+static f64 *g_nextX;
+static f64 *g_nextY;
+// frame stamp of the last enemy that came to rest on a tile centre
+static u32 g_centreClaim[MAP_WIDTH * MAP_HEIGHT];
+
+// per-enemy A* path, valid for one goal and one map revision
+typedef struct
 {
-  return y * MAP_WIDTH + x;
+  v2i tiles[ENEMY_PATH_MAX]; // tiles[0] is where the plan started
+  int length;
+  int cursor; // index of the tile the enemy is on
+  int goalX;
+  int goalY;
+  u32 revision;
+} EnemyPath;
+
+static EnemyPath *g_paths;
+
+// think lists of the frame and shot candidates, one entry per slot at most
+static i32 *g_overdueList;
+static i32 *g_scheduledList;
+static i32 *g_candidates;
+
+static bool enemy_grow(void **array, size_t size, i32 capacity)
+{
+  void *grown = realloc(*array, (size_t)capacity * size);
+  if (!grown)
+    return false;
+  memset((char *)grown + (size_t)g_slotCapacity * size, 0,
+         (size_t)(capacity - g_slotCapacity) * size);
+  *array = grown;
+  return true;
 }
 
-static bool tile_walkable(int x, int y)
+// grows the per-slot state to the store's capacity; false when out of memory
+static bool enemy_reserveSlots(i32 capacity)
 {
-  if (x < 0 || y < 0 || x >= MAP_WIDTH || y >= MAP_HEIGHT)
+  if (capacity <= g_slotCapacity)
+    return true;
+
+  bool ok =
+      enemy_grow((void **)&g_slotGeneration, sizeof(u32), capacity) &&
+      enemy_grow((void **)&g_lastSeen, sizeof(GridCoord), capacity) &&
+      enemy_grow((void **)&g_walkTo, sizeof(GridCoord), capacity) &&
+      enemy_grow((void **)&g_hasLastSeen, sizeof(bool), capacity) &&
+      enemy_grow((void **)&g_sees, sizeof(bool), capacity) &&
+      enemy_grow((void **)&g_moving, sizeof(bool), capacity) &&
+      enemy_grow((void **)&g_overdue, sizeof(bool), capacity) &&
+      enemy_grow((void **)&g_thinkNow, sizeof(bool), capacity) &&
+      enemy_grow((void **)&g_nextX, sizeof(f64), capacity) &&
+      enemy_grow((void **)&g_nextY, sizeof(f64), capacity) &&
+      enemy_grow((void **)&g_paths, sizeof(EnemyPath), capacity) &&
+      enemy_grow((void **)&g_overdueList, sizeof(i32), capacity) &&
+      enemy_grow((void **)&g_scheduledList, sizeof(i32), capacity) &&
+      enemy_grow((void **)&g_candidates, sizeof(i32), capacity);
+  if (!ok)
+  {
+    fprintf(stderr,
+            "\033[31m[ERROR] Could not grow the enemy state to %d\033[0m\n",
+            capacity);
     return false;
-  return worldMap[x][y] <= 0;
+  }
+  g_slotCapacity = capacity;
+  return true;
 }
 
-static double heuristic_cost(int x1, int y1, int x2, int y2)
+static void enemy_resetSlot(i32 index)
 {
-  return fabs((double)x1 - (double)x2) + fabs((double)y1 - (double)y2);
+  g_hasLastSeen[index] = false;
+  g_sees[index] = false;
+  g_moving[index] = false;
+  g_overdue[index] = false;
+  memset(&g_paths[index], 0, sizeof(g_paths[index]));
 }
 
-static int astar_find_path(int startX, int startY, int goalX, int goalY,
-                           GridCoord *outPath, int maxPath)
+// forgets what the previous occupant of the slot knew
+static void enemy_claimSlot(const EntityStore *entities, i32 index)
 {
-  if (!outPath || maxPath <= 0)
-    return 0;
+  if (g_slotGeneration[index] == entities->generation[index])
+    return;
+  g_slotGeneration[index] = entities->generation[index];
+  enemy_resetSlot(index);
+}
 
-  if (startX == goalX && startY == goalY)
-  {
-    outPath[0].x = startX;
-    outPath[0].y = startY;
-    return 1;
-  }
+// A* state for one running job, claimed per chunk so threads never share
+typedef struct
+{
+  SDL_atomic_t busy;
+  bool ready;
+  AStar astar;
+  v2i path[MAP_WIDTH * MAP_HEIGHT];
+} AIScratch;
 
-  double gScore[ASTAR_MAX_NODES];
-  double fScore[ASTAR_MAX_NODES];
-  int cameFrom[ASTAR_MAX_NODES];
-  bool inOpen[ASTAR_MAX_NODES];
-  bool inClosed[ASTAR_MAX_NODES];
+// at most one chunk per worker plus the calling thread runs at a time
+static AIScratch g_scratch[THREADS_MAX + 1];
 
-  for (int i = 0; i < ASTAR_MAX_NODES; ++i)
+static AIScratch *enemy_claimScratch(void)
+{
+  for (;;)
   {
-    gScore[i] = DBL_MAX;
-    fScore[i] = DBL_MAX;
-    cameFrom[i] = -1;
-    inOpen[i] = false;
-    inClosed[i] = false;
+    for (int i = 0; i < THREADS_MAX + 1; ++i)
+    {
+      if (SDL_AtomicCAS(&g_scratch[i].busy, 0, 1))
+        return &g_scratch[i];
+    }
   }
+}
 
-  int openList[ASTAR_MAX_NODES];
-  int openCount = 0;
-
-  if (!tile_walkable(startX, startY))
-    return 0;
-
-  int startIndex = coord_index(startX, startY);
-  int goalIndex = coord_index(goalX, goalY);
-
-  gScore[startIndex] = 0.0;
-  fScore[startIndex] = heuristic_cost(startX, startY, goalX, goalY);
-  openList[openCount++] = startIndex;
-  inOpen[startIndex] = true;
+static void enemy_releaseScratch(AIScratch *scratch)
+{
+  SDL_AtomicSet(&scratch->busy, 0);
+}
 
-  static const int directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+// full path into the scratch buffer, the cache keeps the first stretch
+static bool enemy_planPath(AIScratch *scratch, EnemyPath *cache, int startX,
+                           int startY, int goalX, int goalY)
+{
+  cache->length = 0;
+  cache->cursor = 0;
+  cache->goalX = goalX;
+  cache->goalY = goalY;
+  cache->revision = g_mapRevision;
 
-  while (openCount > 0)
+  if (!scratch->ready)
   {
-    int bestIndex = -1;
-    double bestF = DBL_MAX;
-    for (int i = 0; i < openCount; ++i)
-    {
-      int node = openList[i];
-      if (fScore[node] < bestF)
-      {
-        bestF = fScore[node];
-        bestIndex = i;
-      }
-    }
-
-    if (bestIndex < 0)
-      break;
+    if (astar_init(&scratch->astar, MAP_WIDTH * MAP_HEIGHT) != 0)
+      return false;
+    scratch->ready = true;
+  }
 
-    int current = openList[bestIndex];
-    int currentX = current % MAP_WIDTH;
-    int currentY = current / MAP_WIDTH;
+  const AStarGrid grid = {&g_solidColumns[0][0], MAP_WIDTH, MAP_HEIGHT,
+                          MAP_SOLID_WORDS_Y};
+  i32 length =
+      astar_findPath(&scratch->astar, &grid, startX, startY, goalX, goalY, 0,
+                     scratch->path, MAP_WIDTH * MAP_HEIGHT);
+  if (length > ENEMY_PATH_MAX)
+    length = ENEMY_PATH_MAX;
+  memcpy(cache->tiles, scratch->path, (size_t)length * sizeof(v2i));
+  cache->length = length;
+  return length > 1;
+}
 
-    openCount--;
-    for (int i = bestIndex; i < openCount; ++i)
-      openList[i] = openList[i + 1];
-    inOpen[current] = false;
-    inClosed[current] = true;
+// next tile on the cached path, re-planned when stale or left behind
+static bool enemy_nextPathTile(AIScratch *scratch, int index, int startX,
+                               int startY, int goalX, int goalY,
+                               v2i *outNext)
+{
+  EnemyPath *cache = &g_paths[index];
+  bool valid = cache->length > 1 && cache->goalX == goalX &&
+               cache->goalY == goalY && cache->revision == g_mapRevision;
 
-    if (current == goalIndex)
+  if (valid)
+  {
+    const v2i *here = &cache->tiles[cache->cursor];
+    if (here->x != startX || here->y != startY)
     {
-      int length = 0;
-      int node = goalIndex;
-      while (node >= 0)
-      {
-        if (length >= maxPath)
-          return 0;
-        outPath[length].x = node % MAP_WIDTH;
-        outPath[length].y = node / MAP_WIDTH;
-        if (node == startIndex)
-          break;
-        node = cameFrom[node];
-        length++;
-      }
-
-      if (node != startIndex)
-        return 0;
-
-      length++;
-      for (int i = 0; i < length / 2; ++i)
-      {
-        GridCoord tmp = outPath[i];
-        outPath[i] = outPath[length - 1 - i];
-        outPath[length - 1 - i] = tmp;
-      }
-      return length;
-    }
-
-    for (int d = 0; d < 4; ++d)
-    {
-      int nx = currentX + directions[d][0];
-      int ny = currentY + directions[d][1];
-      if (nx < 0 || ny < 0 || nx >= MAP_WIDTH || ny >= MAP_HEIGHT)
-        continue;
-      if (!tile_walkable(nx, ny) && coord_index(nx, ny) != goalIndex)
-        continue;
-
-      int neighbor = coord_index(nx, ny);
-      if (inClosed[neighbor])
-        continue;
-
-      double tentativeG = gScore[current] + 1.0;
-      if (!inOpen[neighbor])
-      {
-        openList[openCount++] = neighbor;
-        inOpen[neighbor] = true;
-      }
-      else if (tentativeG >= gScore[neighbor])
-      {
-        continue;
-      }
-
-      cameFrom[neighbor] = current;
-      gScore[neighbor] = tentativeG;
-      fScore[neighbor] = tentativeG + heuristic_cost(nx, ny, goalX, goalY);
+      const v2i *ahead = &cache->tiles[cache->cursor + 1];
+      if (cache->cursor + 1 < cache->length && ahead->x == startX &&
+          ahead->y == startY)
+        cache->cursor++;
+      else
+        valid = false;
     }
+    // a cut path runs out before the goal
+    if (cache->cursor + 1 >= cache->length)
+      valid = false;
   }
 
-  return 0;
+  if (!valid &&
+      !enemy_planPath(scratch, cache, startX, startY, goalX, goalY))
+    return false;
+
+  *outNext = cache->tiles[cache->cursor + 1];
+  return true;
 }
 
-static void enemy_move_towards(Sprite *enemy, double targetX, double targetY,
+// where the enemy ends up this frame, written to the intent buffers
+static void enemy_move_towards(int index, f64 fromX, f64 fromY,
+                               double targetX, double targetY,
                                double deltaTime)
 {
-  double dx = targetX - enemy->x;
-  double dy = targetY - enemy->y;
+  double dx = targetX - fromX;
+  double dy = targetY - fromY;
   double dist = sqrt(dx * dx + dy * dy);
-  if (dist < 1e-5)
-  {
-    enemy->x = targetX;
-    enemy->y = targetY;
-    return;
-  }
-
   double maxStep = ENEMY_MOVE_SPEED * deltaTime;
-  if (dist <= maxStep)
+  if (dist < 1e-5 || dist <= maxStep)
   {
-    enemy->x = targetX;
-    enemy->y = targetY;
+    g_nextX[index] = targetX;
+    g_nextY[index] = targetY;
   }
   else
   {
     double scale = maxStep / dist;
-    enemy->x += dx * scale;
-    enemy->y += dy * scale;
+    g_nextX[index] = fromX + dx * scale;
+    g_nextY[index] = fromY + dy * scale;
   }
 }
 
-static void enemy_update_path_follow(Engine *engine, Sprite *enemy,
-                                     double deltaTime)
+// picks the next tile toward the goal; false when there is nowhere to go
+static bool enemy_update_path_follow(AIScratch *scratch, int index,
+                                     int startX, int startY, int goalX,
+                                     int goalY)
 {
-  if (!engine || !enemy)
-    return;
-
-  int startX = (int)floor(enemy->x);
-  int startY = (int)floor(enemy->y);
-  int goalX = (int)floor(engine->player.posX);
-  int goalY = (int)floor(engine->player.posY);
-
   if (startX == goalX && startY == goalY)
-    return;
-
-  GridCoord path[ASTAR_MAX_NODES];
-  int pathLen = astar_find_path(startX, startY, goalX, goalY, path,
-                                ASTAR_MAX_NODES);
-  if (pathLen <= 1)
-    return;
+    return false;
 
-  int nextX = path[1].x;
-  int nextY = path[1].y;
-  enemy->targetX = nextX;
-  enemy->targetY = nextY;
+  v2i next;
+  if (flowfield_hasGoal(goalX, goalY))
+  {
+    // chasing the player: one lookup in the shared field
+    if (!flowfield_nextStep(startX, startY, &next))
+      return false;
+  }
+  else if (!enemy_nextPathTile(scratch, index, startX, startY, goalX, goalY,
+                                &next))
+  {
+    return false;
+  }
 
-  double targetWorldX = (double)nextX + 0.5;
-  double targetWorldY = (double)nextY + 0.5;
-  enemy_move_towards(enemy, targetWorldX, targetWorldY, deltaTime);
+  g_walkTo[index].x = next.x;
+  g_walkTo[index].y = next.y;
+  return true;
 }
 
-static f64 hitscan_distance_to_wall(const Engine *engine, f64 dirX, f64 dirY)
+// ray vs sprite disc; the forward distance along dir, or -1 on a miss
+static inline f64 hitscan_testSprite(const EntityStore *entities, i32 index,
+                                     f64 originX, f64 originY, f64 dirX,
+                                     f64 dirY)
 {
-  if (!engine)
+  // only live sprites are in the grid, and enemies die as they hit 0 health
+  if (entities->kind[index] != SPRITE_ENEMY)
     return -1.0;
 
-  f64 posX = engine->player.posX;
-  f64 posY = engine->player.posY;
+  f64 dx = entities->x[index] - originX;
+  f64 dy = entities->y[index] - originY;
+  f64 forward = dx * dirX + dy * dirY;
+  if (forward <= 0.0)
+    return -1.0;
 
-  i32 mapX = (i32)posX;
-  i32 mapY = (i32)posY;
+  f64 lateral = fabs(dx * dirY - dy * dirX);
+  f64 radius = SPRITE_BASE_HIT_RADIUS * (f64)entities->scale[index];
+  return (lateral > radius) ? -1.0 : forward;
+}
 
-  if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT)
-    return -1.0;
+/* One DDA for walls and enemies: every cell the shot enters has the
+ * sprites of its 3x3 neighbourhood tested, since a hit radius below a tile
+ * never reaches further. Once the shot has passed the closest hit, nothing
+ * in a later cell can be nearer, so the walk stops at the first hit or
+ * wall. Returns the index of the enemy hit, or -1; outWallDistance is -1
+ * when no wall was reached. */
+static i32 hitscan_trace(const EntityStore *entities, f64 originX,
+                         f64 originY, f64 dirX, f64 dirY,
+                         f64 *outWallDistance, f64 *outEnemyDistance)
+{
+  const SpatialGrid *grid = entities_getSpriteGrid();
+  i32 target = -1;
+  f64 closest = DBL_MAX;
+  *outWallDistance = -1.0;
 
+  i32 mapX = (i32)floor(originX);
+  i32 mapY = (i32)floor(originY);
   f64 deltaDistX = (dirX == 0.0) ? DBL_MAX : fabs(1.0 / dirX);
   f64 deltaDistY = (dirY == 0.0) ? DBL_MAX : fabs(1.0 / dirY);
-
   i32 stepX = (dirX < 0.0) ? -1 : 1;
   i32 stepY = (dirY < 0.0) ? -1 : 1;
-
-  f64 sideDistX = (dirX < 0.0) ? (posX - mapX) * deltaDistX
-                               : ((mapX + 1.0) - posX) * deltaDistX;
-  f64 sideDistY = (dirY < 0.0) ? (posY - mapY) * deltaDistY
-                               : ((mapY + 1.0) - posY) * deltaDistY;
-
-  i32 side = 0;
-  for (i32 step = 0; step < 256; ++step)
+  f64 sideDistX = (dirX < 0.0) ? (originX - mapX) * deltaDistX
+                               : ((mapX + 1.0) - originX) * deltaDistX;
+  f64 sideDistY = (dirY < 0.0) ? (originY - mapY) * deltaDistY
+                               : ((mapY + 1.0) - originY) * deltaDistY;
+
+  i32 prevX = 0;
+  i32 prevY = 0;
+  bool havePrev = false;
+  for (i32 step = 0; step < MAP_WIDTH + MAP_HEIGHT + 2; ++step)
   {
+    // neighbourhood cells the previous cell did not already cover
+    for (i32 nx = mapX - 1; grid && nx <= mapX + 1; ++nx)
+    {
+      for (i32 ny = mapY - 1; ny <= mapY + 1; ++ny)
+      {
+        if (nx < 0 || ny < 0 || nx >= MAP_WIDTH || ny >= MAP_HEIGHT)
+          continue;
+        if (havePrev && abs(nx - prevX) <= 1 && abs(ny - prevY) <= 1)
+          continue;
+        for (i32 id = spatialgrid_first(grid, nx, ny); id >= 0;
+             id = spatialgrid_next(grid, id))
+        {
+          f64 forward =
+              hitscan_testSprite(entities, id, originX, originY, dirX, dirY);
+          if (forward >= 0.0 && forward < closest)
+          {
+            closest = forward;
+            target = id;
+          }
+        }
+      }
+    }
+    prevX = mapX;
+    prevY = mapY;
+    havePrev = true;
+
+    f64 crossing;
     if (sideDistX < sideDistY)
     {
+      crossing = sideDistX;
       sideDistX += deltaDistX;
       mapX += stepX;
-      side = 0;
     }
     else
     {
+      crossing = sideDistY;
       sideDistY += deltaDistY;
       mapY += stepY;
-      side = 1;
     }
 
+    if (target >= 0 && closest <= crossing)
+      break;
     if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT)
-      return -1.0;
-
-    if (worldMap[mapX][mapY] > 0)
-      return (side == 0) ? (sideDistX - deltaDistX)
-                         : (sideDistY - deltaDistY);
+      break;
+    if (map_isSolid(mapX, mapY))
+    {
+      *outWallDistance = crossing;
+      // an enemy behind the wall's face is not hit
+      if (target >= 0 && closest >= crossing)
+        target = -1;
+      break;
+    }
   }
 
-  return -1.0;
+  if (target >= 0)
+    *outEnemyDistance = closest;
+  return target;
+}
+
+static AITier enemy_pickTier(int index, f32 x, f32 y, f64 playerX,
+                             f64 playerY)
+{
+  if (g_sees[index])
+    return AI_TIER_NEAR;
+  f64 dx = x - playerX;
+  f64 dy = y - playerY;
+  f64 distanceSq = dx * dx + dy * dy;
+  if (distanceSq < AI_NEAR_DISTANCE * AI_NEAR_DISTANCE)
+    return AI_TIER_NEAR;
+  if (distanceSq < AI_MID_DISTANCE * AI_MID_DISTANCE)
+    return AI_TIER_MID;
+  return AI_TIER_FAR;
 }
 
-static Sprite *find_hitscan_enemy(Engine *engine, f64 dirX, f64 dirY,
-                                  f64 wallDistance, f64 *outDistance)
+// sight check, goal bookkeeping and next tile for one enemy
+static void enemy_think(AIScratch *scratch, int index, int tileX, int tileY,
+                        bool sees, int playerX, int playerY)
 {
-  if (!engine)
-    return NULL;
+  // chase what the enemy can see, otherwise the last place it saw you
+  g_sees[index] = sees;
+  if (sees)
+  {
+    g_lastSeen[index].x = playerX;
+    g_lastSeen[index].y = playerY;
+    g_hasLastSeen[index] = true;
+  }
+  else if (g_hasLastSeen[index] && tileX == g_lastSeen[index].x &&
+           tileY == g_lastSeen[index].y)
+  {
+    g_hasLastSeen[index] = false;
+  }
 
-  f64 closest = (wallDistance > 0.0) ? wallDistance : DBL_MAX;
-  Sprite *target = NULL;
+  g_moving[index] =
+      g_hasLastSeen[index] &&
+      enemy_update_path_follow(scratch, index, tileX, tileY,
+                               g_lastSeen[index].x, g_lastSeen[index].y);
+}
 
-  for (i32 i = 0; i < NUM_SPRITES; ++i)
+typedef struct
+{
+  Engine *engine;
+  const int *alive;
+  int playerX;
+  int playerY;
+  double deltaTime;
+} AIJob;
+
+// read phase over alive[begin, end): thinks where due, then move intents
+static void enemy_readPhase(void *ctx, int begin, int end)
+{
+  AIJob *job = (AIJob *)ctx;
+  const EntityStore *entities = job->engine->entities;
+  const f32 playerPosX = (f32)job->engine->player.posX;
+  const f32 playerPosY = (f32)job->engine->player.posY;
+  AIScratch *scratch = enemy_claimScratch();
+
+  /* The PVS says whether the tiles can see each other at all; the enemies
+   * that pass get their actual sight line checked in batches. */
+  f32 fromX[AI_BATCH], fromY[AI_BATCH];
+  f32 toX[AI_BATCH], toY[AI_BATCH];
+  u8 clear[AI_BATCH];
+  int rayOf[AI_BATCH];
+
+  for (int base = begin; base < end; base += AI_BATCH)
   {
-    Sprite *sprite = &engine->sprites[i];
-    if (!sprite->active || sprite->kind != SPRITE_ENEMY || sprite->health <= 0)
-      continue;
+    int count = end - base;
+    if (count > AI_BATCH)
+      count = AI_BATCH;
 
-    f64 dx = sprite->x - engine->player.posX;
-    f64 dy = sprite->y - engine->player.posY;
+    int rays = 0;
+    for (int d = 0; d < count; ++d)
+    {
+      int i = job->alive[base + d];
+      rayOf[d] = -1;
+      if (!g_thinkNow[i] ||
+          !pvs_canSee((int)floorf(entities->x[i]), (int)floorf(entities->y[i]),
+                      job->playerX, job->playerY))
+        continue;
+      fromX[rays] = entities->x[i];
+      fromY[rays] = entities->y[i];
+      toX[rays] = playerPosX;
+      toY[rays] = playerPosY;
+      rayOf[d] = rays++;
+    }
+    rayquery_lineOfSight(fromX, fromY, toX, toY, clear, rays);
 
-    f64 forward = dx * dirX + dy * dirY;
-    if (forward <= 0.0)
-      continue;
+    for (int d = 0; d < count; ++d)
+    {
+      int i = job->alive[base + d];
+      f64 x = entities->x[i];
+      f64 y = entities->y[i];
+      if (g_thinkNow[i])
+      {
+        bool sees = rayOf[d] >= 0 && clear[rayOf[d]];
+        enemy_think(scratch, i, (int)floor(x), (int)floor(y), sees,
+                    job->playerX, job->playerY);
+      }
 
-    f64 lateral = fabs(dx * dirY - dy * dirX);
-    f64 radius = SPRITE_BASE_HIT_RADIUS * (f64)sprite->scale;
+      // everyone keeps walking toward the tile picked at their last think
+      g_nextX[i] = x;
+      g_nextY[i] = y;
+      if (g_moving[i])
+        enemy_move_towards(i, x, y, (double)g_walkTo[i].x + 0.5,
+                           (double)g_walkTo[i].y + 0.5, job->deltaTime);
+    }
+  }
 
-    if (lateral > radius)
-      continue;
+  enemy_releaseScratch(scratch);
+}
+
+static inline bool enemy_isOpen(f64 x, f64 y)
+{
+  int tileX = (int)floor(x);
+  int tileY = (int)floor(y);
+  return tileX >= 0 && tileX < MAP_WIDTH && tileY >= 0 &&
+         tileY < MAP_HEIGHT && !map_isSolid(tileX, tileY);
+}
+
+typedef struct
+{
+  const EntityStore *entities;
+  const SpatialGrid *grid;
+  const int *alive;
+  double deltaTime;
+} SeparationJob;
+
+/* Separation over alive[begin, end), between the read and commit phases.
+ * Neighbours are read at their start of frame positions and every enemy
+ * only adds to its own intent, so the chunks never depend on each other. */
+static void enemy_separationPhase(void *ctx, int begin, int end)
+{
+  const SeparationJob *job = (const SeparationJob *)ctx;
+  const EntityStore *entities = job->entities;
+  const f64 maxPush = ENEMY_SEPARATION_SPEED * job->deltaTime;
 
-    if (wallDistance > 0.0 && forward >= wallDistance)
+  for (int a = begin; a < end; ++a)
+  {
+    int i = job->alive[a];
+    f64 x = entities->x[i];
+    f64 y = entities->y[i];
+    f64 radius = ENEMY_BODY_RADIUS * entities->scale[i];
+    i32 cell = spatialgrid_cellOf(x, y);
+    i32 cellX = cell / MAP_HEIGHT;
+    i32 cellY = cell % MAP_HEIGHT;
+
+    f64 pushX = 0.0;
+    f64 pushY = 0.0;
+    int neighbours = 0;
+    int scanned = 0;
+    for (i32 nx = cellX - 1; nx <= cellX + 1; ++nx)
+    {
+      for (i32 ny = cellY - 1; ny <= cellY + 1; ++ny)
+      {
+        if (nx < 0 || ny < 0 || nx >= MAP_WIDTH || ny >= MAP_HEIGHT)
+          continue;
+        for (i32 id = spatialgrid_first(job->grid, nx, ny);
+             id >= 0 && scanned < ENEMY_SEPARATION_SCAN &&
+             neighbours < ENEMY_SEPARATION_NEIGHBOURS;
+             id = spatialgrid_next(job->grid, id))
+        {
+          scanned++;
+          if (id == i || entities->kind[id] != SPRITE_ENEMY)
+            continue;
+
+          f64 dx = x - entities->x[id];
+          f64 dy = y - entities->y[id];
+          f64 minDistance = radius + ENEMY_BODY_RADIUS * entities->scale[id];
+          f64 distanceSq = dx * dx + dy * dy;
+          if (distanceSq >= minDistance * minDistance)
+            continue;
+
+          f64 distance = sqrt(distanceSq);
+          f64 overlap = (minDistance - distance) / minDistance;
+          // exactly stacked: split along x, the lower index going left
+          if (distance < 1e-6)
+          {
+            dx = (i < id) ? -1.0 : 1.0;
+            dy = 0.0;
+            distance = 1.0;
+          }
+          pushX += dx / distance * overlap;
+          pushY += dy / distance * overlap;
+          neighbours++;
+        }
+      }
+    }
+    if (neighbours == 0)
       continue;
 
-    if (forward < closest)
+    pushX *= maxPush;
+    pushY *= maxPush;
+    f64 length = sqrt(pushX * pushX + pushY * pushY);
+    if (length > maxPush)
     {
-      closest = forward;
-      target = sprite;
+      pushX *= maxPush / length;
+      pushY *= maxPush / length;
     }
-  }
 
-  if (target && outDistance)
-    *outDistance = closest;
+    // per axis, so an enemy pressed against a wall still slides along it
+    if (enemy_isOpen(g_nextX[i] + pushX, g_nextY[i]))
+      g_nextX[i] += pushX;
+    if (enemy_isOpen(g_nextX[i], g_nextY[i] + pushY))
+      g_nextY[i] += pushY;
+  }
+}
 
-  return target;
+/* Commit phase, in a fixed order so the result does not depend on the
+ * threads. An enemy arriving on a tile centre another enemy already rests
+ * on this frame waits where it is instead of stacking onto it. */
+static void enemy_commitPhase(EntityStore *entities, const int *alive,
+                              int aliveCount)
+{
+  SpatialGrid *grid = entities_getSpriteGrid();
+  for (int a = 0; a < aliveCount; ++a)
+  {
+    int i = alive[a];
+    f64 x = g_nextX[i];
+    f64 y = g_nextY[i];
+    int tileX = (int)floor(x);
+    int tileY = (int)floor(y);
+    bool onCentre = x == (f64)tileX + 0.5 && y == (f64)tileY + 0.5 &&
+                    tileX >= 0 && tileX < MAP_WIDTH && tileY >= 0 &&
+                    tileY < MAP_HEIGHT;
+    if (onCentre)
+    {
+      u32 *claim = &g_centreClaim[tileX * MAP_HEIGHT + tileY];
+      if (*claim == g_aiFrame)
+        continue;
+      *claim = g_aiFrame;
+    }
+    entities->x[i] = (f32)x;
+    entities->y[i] = (f32)y;
+    if (grid)
+      spatialgrid_update(grid, i, x, y);
+  }
 }
 
 void enemies_update(Engine *engine, double deltaTime)
 {
-  if (!engine || !engine->sprites || deltaTime <= 0.0)
+  if (!engine || !engine->entities || deltaTime <= 0.0)
     return;
 
-  for (int i = 0; i < NUM_SPRITES; ++i)
+  int playerX = (int)floor(engine->player.posX);
+  int playerY = (int)floor(engine->player.posY);
+  flowfield_update(playerX, playerY);
+  g_aiFrame++;
+
+  /* Pick who thinks this frame. Near or visible enemies always do, then
+   * whatever the quota pushed out of earlier frames, then the others on the
+   * round robin slot of their tier, until the quota is used up. */
+  EntityStore *entities = engine->entities;
+  if (!enemy_reserveSlots(entities->capacity))
+    return;
+  const int *alive = entities->live[SPRITE_ENEMY];
+  const int aliveCount = entities->liveCount[SPRITE_ENEMY];
+  int *overdue = g_overdueList;
+  int *scheduled = g_scheduledList;
+  int overdueCount = 0;
+  int scheduledCount = 0;
+  for (int a = 0; a < aliveCount; ++a)
+  {
+    int i = alive[a];
+    enemy_claimSlot(entities, i);
+    g_thinkNow[i] = false;
+    AITier tier = enemy_pickTier(i, entities->x[i], entities->y[i],
+                                 engine->player.posX, engine->player.posY);
+    if (tier == AI_TIER_NEAR)
+    {
+      g_thinkNow[i] = true;
+      g_overdue[i] = false;
+    }
+    else if (g_overdue[i])
+      overdue[overdueCount++] = i;
+    else if ((g_aiFrame + (u32)i) % g_tierPeriod[tier] == 0)
+      scheduled[scheduledCount++] = i;
+  }
+
+  int quota = AI_THINK_QUOTA;
+  for (int o = 0; o < overdueCount; ++o)
+  {
+    int i = overdue[o];
+    g_thinkNow[i] = quota > 0;
+    g_overdue[i] = quota <= 0;
+    quota--;
+  }
+  for (int c = 0; c < scheduledCount; ++c)
+  {
+    int i = scheduled[c];
+    g_thinkNow[i] = quota > 0;
+    g_overdue[i] = quota <= 0;
+    quota--;
+  }
+
+  AIJob job = {engine, alive, playerX, playerY, deltaTime};
+  threads_parallelFor(aliveCount, enemy_readPhase, &job);
+
+  const SpatialGrid *grid = entities_getSpriteGrid();
+  if (grid)
+  {
+    SeparationJob separation = {entities, grid, alive, deltaTime};
+    threads_parallelFor(aliveCount, enemy_separationPhase, &separation);
+  }
+  enemy_commitPhase(entities, alive, aliveCount);
+}
+
+void enemies_reset(void)
+{
+  for (i32 i = 0; i < g_slotCapacity; ++i)
+    enemy_resetSlot(i);
+  memset(g_centreClaim, 0, sizeof(g_centreClaim));
+  g_aiFrame = 0;
+}
+
+/* One candidate against a run of pellets: pellet p takes it when the
+ * candidate sits ahead of the muzzle, within its hit radius of the pellet
+ * line and closer than the best hit so far. */
+static void hitscan_testPelletsScalar(f32 dx, f32 dy, f32 radius, i32 id,
+                                      const f32 *dirX, const f32 *dirY,
+                                      f32 *best, i32 *who, i32 count)
+{
+  for (i32 p = 0; p < count; ++p)
+  {
+    f32 forward = dx * dirX[p] + dy * dirY[p];
+    f32 lateral = fabsf(dx * dirY[p] - dy * dirX[p]);
+    int hit = forward > 0.0f && lateral <= radius && forward < best[p];
+    best[p] = hit ? forward : best[p];
+    who[p] = hit ? id : who[p];
+  }
+}
+
+#ifdef HITSCAN_X86
+
+HITSCAN_TARGET("sse2")
+static void hitscan_testPellets4(f32 dx, f32 dy, f32 radius, i32 id,
+                                 const f32 *dirX, const f32 *dirY, f32 *best,
+                                 i32 *who)
+{
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128 vdx = _mm_set1_ps(dx);
+  const __m128 vdy = _mm_set1_ps(dy);
+  __m128 px = _mm_loadu_ps(dirX);
+  __m128 py = _mm_loadu_ps(dirY);
+  __m128 vbest = _mm_loadu_ps(best);
+  __m128 forward = _mm_add_ps(_mm_mul_ps(vdx, px), _mm_mul_ps(vdy, py));
+  __m128 lateral = _mm_and_ps(
+      _mm_sub_ps(_mm_mul_ps(vdx, py), _mm_mul_ps(vdy, px)), absMask);
+  __m128 hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmpgt_ps(forward, _mm_setzero_ps()),
+                 _mm_cmple_ps(lateral, _mm_set1_ps(radius))),
+      _mm_cmplt_ps(forward, vbest));
+  __m128i hitInt = _mm_castps_si128(hit);
+  __m128i vwho = _mm_loadu_si128((const __m128i *)who);
+  _mm_storeu_ps(best,
+                _mm_or_ps(_mm_and_ps(hit, forward), _mm_andnot_ps(hit, vbest)));
+  _mm_storeu_si128((__m128i *)who,
+                   _mm_or_si128(_mm_and_si128(hitInt, _mm_set1_epi32(id)),
+                                _mm_andnot_si128(hitInt, vwho)));
+}
+
+HITSCAN_TARGET("avx2")
+static void hitscan_testPellets8(f32 dx, f32 dy, f32 radius, i32 id,
+                                 const f32 *dirX, const f32 *dirY, f32 *best,
+                                 i32 *who)
+{
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+  const __m256 vdx = _mm256_set1_ps(dx);
+  const __m256 vdy = _mm256_set1_ps(dy);
+  __m256 px = _mm256_loadu_ps(dirX);
+  __m256 py = _mm256_loadu_ps(dirY);
+  __m256 vbest = _mm256_loadu_ps(best);
+  __m256 forward =
+      _mm256_add_ps(_mm256_mul_ps(vdx, px), _mm256_mul_ps(vdy, py));
+  __m256 lateral = _mm256_and_ps(
+      _mm256_sub_ps(_mm256_mul_ps(vdx, py), _mm256_mul_ps(vdy, px)),
+      absMask);
+  __m256 hit = _mm256_and_ps(
+      _mm256_and_ps(
+          _mm256_cmp_ps(forward, _mm256_setzero_ps(), _CMP_GT_OQ),
+          _mm256_cmp_ps(lateral, _mm256_set1_ps(radius), _CMP_LE_OQ)),
+      _mm256_cmp_ps(forward, vbest, _CMP_LT_OQ));
+  __m256i vwho = _mm256_loadu_si256((const __m256i *)who);
+  _mm256_storeu_ps(best, _mm256_blendv_ps(vbest, forward, hit));
+  _mm256_storeu_si256(
+      (__m256i *)who,
+      _mm256_castps_si256(_mm256_blendv_ps(
+          _mm256_castsi256_ps(vwho),
+          _mm256_castsi256_ps(_mm256_set1_epi32(id)), hit)));
+}
+
+#endif
+
+static void hitscan_testPellets(f32 dx, f32 dy, f32 radius, i32 id,
+                                const f32 *dirX, const f32 *dirY, f32 *best,
+                                i32 *who, i32 count)
+{
+  i32 p = 0;
+#ifdef HITSCAN_X86
+  // follows the SIMD level the blit kernels picked, RAYCASTER_SIMD included
+  if (g_blit.level >= BLIT_AVX2)
+  {
+    for (; p + 8 <= count; p += 8)
+      hitscan_testPellets8(dx, dy, radius, id, dirX + p, dirY + p, best + p,
+                           who + p);
+  }
+  if (g_blit.level >= BLIT_SSE2)
+  {
+    for (; p + 4 <= count; p += 4)
+      hitscan_testPellets4(dx, dy, radius, id, dirX + p, dirY + p, best + p,
+                           who + p);
+  }
+#endif
+  hitscan_testPelletsScalar(dx, dy, radius, id, dirX + p, dirY + p, best + p,
+                            who + p, count - p);
+}
+
+/* All pellets of one shot together: the wall distances come from one
+ * packet ray query, the sprite candidates from one widened corridor along
+ * the centre pellet, and every candidate is tested against all pellets
+ * four or eight at a time. */
+static void hitscan_firePellets(Engine *engine, const WeaponProperties *weapon,
+                                f64 *outCentreDistance)
+{
+  EntityStore *entities = engine->entities;
+  i32 pellets = weapon->pellets < 1 ? 1 : weapon->pellets;
+  if (pellets > HITSCAN_MAX_PELLETS)
+    pellets = HITSCAN_MAX_PELLETS;
+  const f64 originX = engine->player.posX;
+  const f64 originY = engine->player.posY;
+  const f64 baseAngle = atan2(engine->player.dirY, engine->player.dirX);
+
+  f32 oxs[HITSCAN_MAX_PELLETS], oys[HITSCAN_MAX_PELLETS];
+  f32 dirX[HITSCAN_MAX_PELLETS], dirY[HITSCAN_MAX_PELLETS];
+  f32 maxDistance[HITSCAN_MAX_PELLETS], wall[HITSCAN_MAX_PELLETS];
+  f32 best[HITSCAN_MAX_PELLETS];
+  i32 who[HITSCAN_MAX_PELLETS];
+  RayHit hits[HITSCAN_MAX_PELLETS];
+
+  // evenly fanned across the cone, so a shot is the same every time
+  for (i32 p = 0; p < pellets; ++p)
+  {
+    f64 t = (pellets > 1) ? (f64)p / (f64)(pellets - 1) - 0.5 : 0.0;
+    f64 angle = baseAngle + t * weapon->spread;
+    oxs[p] = (f32)originX;
+    oys[p] = (f32)originY;
+    dirX[p] = (f32)cos(angle);
+    dirY[p] = (f32)sin(angle);
+    maxDistance[p] = FLT_MAX;
+  }
+  rayquery_cast(oxs, oys, dirX, dirY, maxDistance, hits, pellets);
+
+  f32 farthest = 0.0f;
+  for (i32 p = 0; p < pellets; ++p)
+  {
+    wall[p] = hits[p].hit ? hits[p].distance : FLT_MAX;
+    best[p] = wall[p];
+    who[p] = -1;
+    if (hits[p].hit && wall[p] > farthest)
+      farthest = wall[p];
+  }
+  if (farthest <= 0.0f)
+    farthest = (f32)(MAP_WIDTH + MAP_HEIGHT);
+
+  // the cone is at most this many cells off the centre pellet's cells
+  const SpatialGrid *grid = entities_getSpriteGrid();
+  i32 candidateCount = 0;
+  i32 *candidates = g_candidates;
+  if (grid && enemy_reserveSlots(entities->capacity))
   {
-    Sprite *sprite = &engine->sprites[i];
-    if (!sprite->active || sprite->kind != SPRITE_ENEMY || sprite->health <= 0)
+    i32 halfWidth =
+        (i32)ceil((f64)farthest * tan(weapon->spread * 0.5)) + 1;
+    candidateCount = spatialgrid_queryRay(
+        grid, originX, originY, engine->player.dirX, engine->player.dirY,
+        (f64)farthest, halfWidth, candidates, entities->capacity);
+  }
+
+  for (i32 c = 0; c < candidateCount; ++c)
+  {
+    const i32 id = candidates[c];
+    if (entities->kind[id] != SPRITE_ENEMY)
       continue;
 
-    enemy_update_path_follow(engine, sprite, deltaTime);
+    const f32 dx = (f32)(entities->x[id] - originX);
+    const f32 dy = (f32)(entities->y[id] - originY);
+    const f32 radius = (f32)SPRITE_BASE_HIT_RADIUS * entities->scale[id];
+    hitscan_testPellets(dx, dy, radius, id, dirX, dirY, best, who, pellets);
   }
+
+  // damage per target, summed over its pellets before it is applied
+  i32 targets[HITSCAN_MAX_PELLETS];
+  i32 targetHits[HITSCAN_MAX_PELLETS];
+  i32 targetCount = 0;
+  for (i32 p = 0; p < pellets; ++p)
+  {
+    if (who[p] < 0)
+      continue;
+    i32 t = 0;
+    while (t < targetCount && targets[t] != who[p])
+      ++t;
+    if (t == targetCount)
+    {
+      targets[targetCount] = who[p];
+      targetHits[targetCount++] = 0;
+    }
+    targetHits[t]++;
+  }
+
+  /* Each pellet carries damage / pellets. Rounding the running total once
+   * and handing out the differences keeps the remainders, so a full hit
+   * still deals exactly weapon->damage. */
+  i32 pelletsSoFar = 0;
+  i32 damageSoFar = 0;
+  for (i32 t = 0; t < targetCount; ++t)
+  {
+    pelletsSoFar += targetHits[t];
+    i32 damageUpTo =
+        (i32)(((i64)weapon->damage * pelletsSoFar + pellets / 2) / pellets);
+    Sprite *target = &entities->cold[targets[t]];
+    target->health -= damageUpTo - damageSoFar;
+    damageSoFar = damageUpTo;
+    if (target->health <= 0)
+    {
+      target->health = 0;
+      entities_retireSprite(targets[t]);
+    }
+  }
+
+  const i32 centre = pellets / 2;
+  *outCentreDistance = (best[centre] < FLT_MAX) ? (f64)best[centre] : -1.0;
 }
 
-void enemies_applyHitscanDamage(Engine *engine, i32 damage)
+void enemies_applyHitscanDamage(Engine *engine, const WeaponProperties *weapon)
 {
-  if (!engine || damage <= 0)
+  if (!engine || !weapon || weapon->damage <= 0)
     return;
 
   f64 dirX = engine->player.dirX;
   f64 dirY = engine->player.dirY;
+  dynlight_spawn((f32)engine->player.posX, (f32)engine->player.posY,
+                 MUZZLE_FLASH_RADIUS, MUZZLE_FLASH_INTENSITY,
+                 MUZZLE_FLASH_LIFETIME);
 
-  f64 wallDistance = hitscan_distance_to_wall(engine, dirX, dirY);
+  if (weapon->pellets > 1)
+  {
+    // one impact flash, where the centre pellet lands
+    f64 impactDistance = -1.0;
+    hitscan_firePellets(engine, weapon, &impactDistance);
+    impactDistance -= 0.05;
+    if (impactDistance > 0.0)
+      dynlight_spawn((f32)(engine->player.posX + dirX * impactDistance),
+                     (f32)(engine->player.posY + dirY * impactDistance),
+                     IMPACT_FLASH_RADIUS, IMPACT_FLASH_INTENSITY,
+                     IMPACT_FLASH_LIFETIME);
+    return;
+  }
 
+  f64 wallDistance = -1.0;
   f64 enemyDistance = 0.0;
-  Sprite *target =
-      find_hitscan_enemy(engine, dirX, dirY, wallDistance, &enemyDistance);
-  if (!target)
+  i32 index =
+      hitscan_trace(engine->entities, engine->player.posX,
+                    engine->player.posY, dirX, dirY, &wallDistance,
+                    &enemyDistance);
+
+  // a smaller flash where the shot lands
+  f64 impactDistance = index >= 0 ? enemyDistance : wallDistance - 0.05;
+  dynlight_spawn((f32)(engine->player.posX + dirX * impactDistance),
+                 (f32)(engine->player.posY + dirY * impactDistance),
+                 IMPACT_FLASH_RADIUS, IMPACT_FLASH_INTENSITY,
+                 IMPACT_FLASH_LIFETIME);
+
+  if (index < 0)
     return;
 
-  target->health -= damage;
+  Sprite *target = &engine->entities->cold[index];
+  target->health -= weapon->damage;
   if (target->health <= 0)
   {
     target->health = 0;
-    target->active = 0;
+    entities_retireSprite(index);
   }
 }
@@ -1,7 +1,12 @@
 #include "engine.h"
+#include "blit.h"
 #include "entities.h"
 #include "map.h"
 #include "sound.h"
+#include "texcache.h"
+#include "threads.h"
+#include "postprocess.h"
+#include "upscale.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -45,12 +50,15 @@ int engine_init(Engine *engine) {
     return 1;
   if (TTF_Init() == -1)
     return 1;
+  threads_init(0);
+  blit_init();
+  upscale_init(&engine->game);
 
   // Initialize objects inside engine
   engine->player = createPlayer();
   engine->textures = createTextures();
   engine->sound = createSound();
-  engine->sprites = entities_createWorldSprites();
+  engine->entities = entities_createWorldSprites();
   engine->font = font_init();
   engine_applyPlayerSpawn(&engine->player);
 
@@ -65,6 +73,7 @@ int engine_init(Engine *engine) {
   buffers_init(&engine->game);
   loadAllAnimations();
   textures_load(&engine->textures);
+  texcache_init(&engine->textures);
   loadSounds(&engine->sound);
   loadMusic(&engine->sound);
 
@@ -95,7 +104,9 @@ void engine_cleanup(Engine *engine, int exitCode) {
   freeAllAnimations();
 
   printf("\033[32m[CLEANUP] Freeing textures...\033[0m\n");
+  texcache_shutdown();
   for (int i = 0; i < NUM_TEXTURES; i++) {
+    mip_free(&engine->textures.mips[i]);
     if (engine->textures.textures[i]) {
       free(engine->textures.textures[i]);
       engine->textures.textures[i] = NULL;
@@ -119,16 +130,23 @@ void engine_cleanup(Engine *engine, int exitCode) {
     engine->font.title = NULL;
   }
 
+  printf("\033[32m[CLEANUP] Stopping worker threads...\033[0m\n");
+  threads_shutdown();
+
   printf("\033[32m[CLEANUP] Destroying SDL renderer, window, and "
          "texture...\033[0m\n");
+  upscale_cleanup();
+  post_cleanup();
+  for (int i = 0; i < SWAP_MAX; i++) {
+    if (engine->game.screen_textures[i]) {
+      SDL_DestroyTexture(engine->game.screen_textures[i]);
+      engine->game.screen_textures[i] = NULL;
+    }
+  }
   if (engine->game.renderer) {
     SDL_DestroyRenderer(engine->game.renderer);
     engine->game.renderer = NULL;
   }
-  if (engine->game.screen_texture) {
-    SDL_DestroyTexture(engine->game.screen_texture);
-    engine->game.screen_texture = NULL;
-  }
   if (engine->game.window) {
     SDL_DestroyWindow(engine->game.window);
     engine->game.window = NULL;
@@ -138,12 +156,9 @@ void engine_cleanup(Engine *engine, int exitCode) {
 
   // Free buffes
   printf("\033[32m[CLEANUP] Freeing game buffers...\033[0m\n");
-  if (engine->game.buffer) {
-    free(engine->game.buffer);
-    engine->game.buffer = NULL;
-  }
-  if (engine->game.Rbuffer) {
-    free(engine->game.Rbuffer);
+  if (engine->game.Fbuffer) {
+    free(engine->game.Fbuffer);
+    engine->game.Fbuffer = NULL;
     engine->game.Rbuffer = NULL;
   }
   if (engine->game.Zbuffer) {
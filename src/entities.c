@@ -1,6 +1,14 @@
 #include "animation.h"
+#include "automap.h"
+#include "distfield.h"
+#include "dynlight.h"
 #include "entities.h"
+#include "enemies.h"
+#include "fog.h"
+#include "lightmap.h"
 #include "player.h"
+#include "postprocess.h"
+#include "pvs.h"
 #include "raycast.h"
 #include "texture.h"
 #include "map.h"
@@ -14,8 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-static Sprite worldSprites[NUM_SPRITES];
-static i32 worldSpriteCount = 0;
+static EntityStore g_entities;
 static int worldInitialized = 0;
 
 typedef struct
@@ -94,6 +101,11 @@ typedef struct
 
 static LeverInstance *g_levers = NULL;
 static int g_leverCount = 0;
+
+// interaction points of the levers and the active sprites, by tile
+static SpatialGrid g_leverGrid;
+static SpatialGrid g_spriteGrid;
+static int g_gridsReady = 0;
 static int g_leverCapacity = 0;
 static int g_leverDoorMap[MAP_WIDTH][MAP_HEIGHT];
 static int g_leverTileMap[MAP_WIDTH][MAP_HEIGHT];
@@ -538,56 +550,26 @@ static void lever_alignPosition(LeverInstance *lever)
   lever->tileY = (int)floor(lever->leverY);
 }
 
-static Sprite sprite_make(f64 x, f64 y, SpriteKind kind,
-                          SpriteAppearance appearance, f32 scale, i32 health)
+static Sprite sprite_make(SpriteAppearance appearance, i32 health)
 {
   Sprite sprite;
-  sprite.x = x;
-  sprite.y = y;
-  sprite.scale = scale;
-  sprite.kind = kind;
   sprite.appearance = appearance;
-  sprite.active = 1;
   sprite.health = health;
   sprite.auxTextureId = -1;
-  sprite.targetX = -1;
-  sprite.targetY = -1;
   sprite.actionType = 0;
   sprite.stateFlags = 0;
   return sprite;
 }
 
-static Sprite *entities_pushSprite(Sprite sprite)
-{
-  if (worldSpriteCount >= NUM_SPRITES)
-    return NULL;
-
-  worldSprites[worldSpriteCount] = sprite;
-  return &worldSprites[worldSpriteCount++];
-}
-
-static void fill_unused_slots(void)
+static int entities_pushSprite(f64 x, f64 y, SpriteKind kind, f32 scale,
+                               Sprite sprite)
 {
-  for (i32 i = worldSpriteCount; i < NUM_SPRITES; ++i)
-  {
-    worldSprites[i].x = 0.0;
-    worldSprites[i].y = 0.0;
-    worldSprites[i].scale = 1.0f;
-    worldSprites[i].kind = SPRITE_DECORATION;
-    worldSprites[i].appearance = spriteAppearanceFromTexture(TEX_GREENLIGHT);
-    worldSprites[i].active = 0;
-    worldSprites[i].health = 0;
-    worldSprites[i].auxTextureId = -1;
-    worldSprites[i].targetX = -1;
-    worldSprites[i].targetY = -1;
-    worldSprites[i].actionType = 0;
-    worldSprites[i].stateFlags = 0;
-  }
+  return entities_spawnSprite(kind, x, y, scale, sprite).index >= 0;
 }
 
 static void entities_populateDefaults(void)
 {
-  worldSpriteCount = 0;
+  entitystore_clear(&g_entities);
   entities_resetSpawnToDefaults();
   lever_clear();
   walltext_clear();
@@ -629,32 +611,29 @@ static void entities_populateDefaults(void)
 
   for (i32 i = 0; i < (i32)(sizeof(decorations) / sizeof(decorations[0])); ++i)
   {
-    const f32 scale = decorations[i].scale;
     Sprite sprite =
-        sprite_make(decorations[i].x, decorations[i].y, SPRITE_DECORATION,
-                    spriteAppearanceFromTexture(decorations[i].textureId),
-                    scale, 0);
-    entities_pushSprite(sprite);
+        sprite_make(spriteAppearanceFromTexture(decorations[i].textureId), 0);
+    entities_pushSprite(decorations[i].x, decorations[i].y, SPRITE_DECORATION,
+                        decorations[i].scale, sprite);
   }
 
   for (i32 i = 0; i < (i32)(sizeof(pickups) / sizeof(pickups[0])); ++i)
   {
     Sprite sprite =
-        sprite_make(pickups[i].x, pickups[i].y, SPRITE_PICKUP,
-                    spriteAppearanceFromTexture(pickups[i].textureId),
-                    pickups[i].scale, 0);
-    entities_pushSprite(sprite);
+        sprite_make(spriteAppearanceFromTexture(pickups[i].textureId), 0);
+    entities_pushSprite(pickups[i].x, pickups[i].y, SPRITE_PICKUP,
+                        pickups[i].scale, sprite);
   }
 
   for (i32 i = 0; i < (i32)(sizeof(enemies) / sizeof(enemies[0])); ++i)
   {
     Animation *anim = animation_from_name(enemies[i].animation);
     Sprite sprite =
-        sprite_make(enemies[i].x, enemies[i].y, SPRITE_ENEMY,
-                    anim ? spriteAppearanceFromAnimation(anim)
+        sprite_make(anim ? spriteAppearanceFromAnimation(anim)
                          : spriteAppearanceFromTexture(TEX_GREENLIGHT),
-                    enemies[i].scale, enemies[i].health);
-    entities_pushSprite(sprite);
+                    enemies[i].health);
+    entities_pushSprite(enemies[i].x, enemies[i].y, SPRITE_ENEMY,
+                        enemies[i].scale, sprite);
   }
 }
 
@@ -807,6 +786,34 @@ static void entities_parse_settings(const char *json)
       wrapped += 360.0;
     g_playerSpawnDirDegrees = wrapped;
   }
+
+  if (json_get_double(objectStart, objectEnd, "dynamic_light_cap", &value) == 1)
+    dynlight_setCap((int)value);
+
+  char lutPath[256];
+  if (json_get_string(objectStart, objectEnd, "color_lut", lutPath,
+                      sizeof(lutPath)) == 1)
+    post_loadLUT(lutPath);
+
+  double fogStart = g_fog.start;
+  double farPlane = g_fog.farDistance;
+  int hasFogStart =
+      json_get_double(objectStart, objectEnd, "fog_start", &fogStart) == 1;
+  json_get_double(objectStart, objectEnd, "far_plane", &farPlane);
+  fog_setRange((f32)fogStart, (f32)farPlane);
+  if (hasFogStart)
+    fog_setEnabled(1);
+  if (json_get_double(objectStart, objectEnd, "far_plane_steps", &value) == 1)
+    fog_setMaxSteps((int)value);
+
+  double fogR = (g_fog.color >> 16) & 0xFF;
+  double fogG = (g_fog.color >> 8) & 0xFF;
+  double fogB = g_fog.color & 0xFF;
+  json_get_double(objectStart, objectEnd, "fog_color_r", &fogR);
+  json_get_double(objectStart, objectEnd, "fog_color_g", &fogG);
+  json_get_double(objectStart, objectEnd, "fog_color_b", &fogB);
+  fog_setColor(((u32)fogR & 0xFF) << 16 | ((u32)fogG & 0xFF) << 8 |
+               ((u32)fogB & 0xFF));
 }
 
 static int texture_from_name(const char *name, i32 *out)
@@ -884,13 +891,11 @@ static int parse_decoration_object(const char *start, const char *end)
   if (!texture_from_name(textureName, &textureId))
     return -1;
 
-  Sprite sprite =
-      sprite_make(x, y, SPRITE_DECORATION,
-                  spriteAppearanceFromTexture(textureId), (f32)scale, 0);
-  if (!entities_pushSprite(sprite))
+  Sprite sprite = sprite_make(spriteAppearanceFromTexture(textureId), 0);
+  if (!entities_pushSprite(x, y, SPRITE_DECORATION, (f32)scale, sprite))
   {
     fprintf(stderr,
-            "\033[31m[ERROR] Too many sprites, decoration skipped\033[0m\n");
+            "\033[31m[ERROR] Out of memory, decoration skipped\033[0m\n");
     return -1;
   }
 
@@ -933,13 +938,11 @@ static int parse_pickup_object(const char *start, const char *end)
   if (!texture_from_name(textureName, &textureId))
     return -1;
 
-  Sprite sprite = sprite_make(x, y, SPRITE_PICKUP,
-                              spriteAppearanceFromTexture(textureId),
-                              (f32)scale, 0);
-  if (!entities_pushSprite(sprite))
+  Sprite sprite = sprite_make(spriteAppearanceFromTexture(textureId), 0);
+  if (!entities_pushSprite(x, y, SPRITE_PICKUP, (f32)scale, sprite))
   {
     fprintf(stderr,
-            "\033[31m[ERROR] Too many sprites, pickup skipped\033[0m\n");
+            "\033[31m[ERROR] Out of memory, pickup skipped\033[0m\n");
     return -1;
   }
 
@@ -992,11 +995,10 @@ static int parse_enemy_object(const char *start, const char *end)
     return -1;
 
   Sprite sprite =
-      sprite_make(x, y, SPRITE_ENEMY, spriteAppearanceFromAnimation(animation),
-                  (f32)scale, (i32)healthValue);
-  if (!entities_pushSprite(sprite))
+      sprite_make(spriteAppearanceFromAnimation(animation), (i32)healthValue);
+  if (!entities_pushSprite(x, y, SPRITE_ENEMY, (f32)scale, sprite))
   {
-    fprintf(stderr, "\033[31m[ERROR] Too many sprites, enemy skipped\033[0m\n");
+    fprintf(stderr, "\033[31m[ERROR] Out of memory, enemy skipped\033[0m\n");
     return -1;
   }
 
@@ -1262,20 +1264,47 @@ static int parse_wall_text_object(const char *start, const char *end)
   return 0;
 }
 
+// every system that caches map data hears about door changes from here
+static void entities_setDoorTile(int tileX, int tileY, int value)
+{
+  map_setTile(tileX, tileY, value);
+  lightmap_onTileChanged(tileX, tileY);
+  pvs_onTileChanged(tileX, tileY);
+  automap_onTileChanged(tileX, tileY);
+  distfield_onTileChanged(tileX, tileY);
+}
+
 void entities_tryInteract(Engine *engine)
 {
   if (!engine)
     return;
 
-  const double interactRangeSq = 1.4 * 1.4;
+  const double interactRange = 1.4;
+  const double interactRangeSq = interactRange * interactRange;
   double px = engine->player.posX;
   double py = engine->player.posY;
   double dirX = engine->player.dirX;
   double dirY = engine->player.dirY;
 
-  for (int i = 0; i < g_leverCount; ++i)
+  if (!g_gridsReady || g_leverCount <= 0)
+    return;
+
+  // levers that share a door toggle in index order, as they always did
+  int nearby[64];
+  int nearbyCount = spatialgrid_queryRadius(&g_leverGrid, px, py,
+                                            interactRange, nearby, 64);
+  for (int a = 1; a < nearbyCount; ++a)
+  {
+    int value = nearby[a];
+    int b = a - 1;
+    for (; b >= 0 && nearby[b] > value; --b)
+      nearby[b + 1] = nearby[b];
+    nearby[b + 1] = value;
+  }
+
+  for (int n = 0; n < nearbyCount; ++n)
   {
-    LeverInstance *lever = &g_levers[i];
+    LeverInstance *lever = &g_levers[nearby[n]];
     double dx = lever->interactX - px;
     double dy = lever->interactY - py;
     double distSq = dx * dx + dy * dy;
@@ -1304,14 +1333,15 @@ void entities_tryInteract(Engine *engine)
         if (playerInsideTile)
         {
           lever->activated = 1;
-          worldMap[lever->doorX][lever->doorY] = lever->openTileValue;
+          entities_setDoorTile(lever->doorX, lever->doorY,
+                               lever->openTileValue);
           continue;
         }
       }
 
       int newValue =
           lever->activated ? lever->openTileValue : lever->originalTileValue;
-      worldMap[lever->doorX][lever->doorY] = newValue;
+      entities_setDoorTile(lever->doorX, lever->doorY, newValue);
     }
   }
 }
@@ -1443,9 +1473,11 @@ static int entities_loadFromJSONFile(const char *path)
   buffer[length] = '\0';
 
   entities_resetSpawnToDefaults();
+  post_resetLevelSettings();
+  dynlight_setCap(DYNLIGHT_DEFAULT_CAP);
   entities_parse_settings(buffer);
 
-  worldSpriteCount = 0;
+  entitystore_clear(&g_entities);
   int result = 0;
   lever_clear();
   walltext_clear();
@@ -1473,7 +1505,7 @@ static int entities_loadFromJSONFile(const char *path)
 
   if (result != 0)
   {
-    worldSpriteCount = 0;
+    entitystore_clear(&g_entities);
     return -1;
   }
 
@@ -1490,13 +1522,80 @@ void entities_getPlayerSpawn(double *outX, double *outY, double *outDirDegrees)
     *outDirDegrees = g_playerSpawnDirDegrees;
 }
 
-Sprite *entities_createWorldSprites(void)
+static void entities_buildGrids(void)
+{
+  if (!g_gridsReady)
+  {
+    if (spatialgrid_init(&g_spriteGrid, ENTITY_INITIAL_CAPACITY) != 0 ||
+        spatialgrid_init(&g_leverGrid, g_leverCount > 0 ? g_leverCount : 1) !=
+            0)
+      return;
+    g_gridsReady = 1;
+  }
+  /* On failure the levers past the old capacity just are not interactive,
+   * and the sprites past it are not collided with or shot. */
+  spatialgrid_reserve(&g_leverGrid, g_leverCount);
+  spatialgrid_reserve(&g_spriteGrid, g_entities.capacity);
+
+  spatialgrid_clear(&g_spriteGrid);
+  for (i32 kind = 0; kind < ENTITY_KIND_COUNT; ++kind)
+  {
+    for (i32 n = 0; n < g_entities.liveCount[kind]; ++n)
+    {
+      i32 i = g_entities.live[kind][n];
+      spatialgrid_update(&g_spriteGrid, i, g_entities.x[i], g_entities.y[i]);
+    }
+  }
+
+  spatialgrid_clear(&g_leverGrid);
+  for (int i = 0; i < g_leverCount; ++i)
+    spatialgrid_update(&g_leverGrid, i, g_levers[i].interactX,
+                       g_levers[i].interactY);
+}
+
+SpatialGrid *entities_getSpriteGrid(void)
+{
+  return g_gridsReady ? &g_spriteGrid : NULL;
+}
+
+EntityHandle entities_spawnSprite(SpriteKind kind, f64 x, f64 y, f32 scale,
+                                  Sprite sprite)
+{
+  EntityHandle handle = {-1, 0};
+  i32 index =
+      entitystore_spawn(&g_entities, kind, (f32)x, (f32)y, scale, &sprite);
+  if (index < 0)
+    return handle;
+
+  if (g_gridsReady)
+  {
+    if (spatialgrid_reserve(&g_spriteGrid, g_entities.capacity) != 0)
+    {
+      entitystore_kill(&g_entities, index);
+      return handle;
+    }
+    spatialgrid_update(&g_spriteGrid, index, x, y);
+  }
+  return entitystore_handle(&g_entities, index);
+}
+
+void entities_retireSprite(i32 index)
+{
+  if (!entitystore_isLive(&g_entities, index))
+    return;
+  entitystore_kill(&g_entities, index);
+  if (g_gridsReady)
+    spatialgrid_remove(&g_spriteGrid, index);
+}
+
+EntityStore *entities_createWorldSprites(void)
 {
   if (worldInitialized)
-    return worldSprites;
+    return &g_entities;
 
-  worldSpriteCount = 0;
+  entitystore_clear(&g_entities);
   entities_resetSpawnToDefaults();
+  fog_resetLevelSettings();
 
   if (entities_loadFromJSONFile("levels/1/entities.json") != 0)
   {
@@ -1505,25 +1604,26 @@ Sprite *entities_createWorldSprites(void)
     entities_populateDefaults();
   }
 
-  fill_unused_slots();
+  entities_buildGrids();
+  lightmap_build(&g_entities);
+  pvs_build();
+  automap_reset();
+  distfield_build();
+  dynlight_reset();
+  enemies_reset();
   worldInitialized = 1;
-  return worldSprites;
-}
-
-Sprite *entities_getSprites(void)
-{
-  return worldSprites;
+  return &g_entities;
 }
 
-i32 entities_getSpriteCount(void)
+EntityStore *entities_getStore(void)
 {
-  return worldSpriteCount;
+  return &g_entities;
 }
 
 void entities_reset(void)
 {
   worldInitialized = 0;
-  worldSpriteCount = 0;
+  entitystore_clear(&g_entities);
   lever_clear();
   walltext_clear();
   entities_resetSpawnToDefaults();
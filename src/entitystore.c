@@ -0,0 +1,116 @@
+#include "entitystore.h"
+#include <stdlib.h>
+#include <string.h>
+
+void entitystore_free(EntityStore *store)
+{
+  free(store->x);
+  free(store->y);
+  free(store->scale);
+  free(store->kind);
+  for (i32 k = 0; k < ENTITY_KIND_COUNT; ++k)
+    free(store->live[k]);
+  free(store->livePos);
+  free(store->generation);
+  free(store->freeSlots);
+  free(store->cold);
+  memset(store, 0, sizeof(*store));
+}
+
+// reallocs one array, keeping it when that fails
+static bool entitystore_grow(void **array, size_t size, i32 capacity)
+{
+  void *grown = realloc(*array, (size_t)capacity * size);
+  if (!grown)
+    return false;
+  *array = grown;
+  return true;
+}
+
+int entitystore_reserve(EntityStore *store, i32 capacity)
+{
+  if (capacity <= store->capacity)
+    return 0;
+
+  bool ok = entitystore_grow((void **)&store->x, sizeof(f32), capacity) &&
+            entitystore_grow((void **)&store->y, sizeof(f32), capacity) &&
+            entitystore_grow((void **)&store->scale, sizeof(f32), capacity) &&
+            entitystore_grow((void **)&store->kind, sizeof(u8), capacity) &&
+            entitystore_grow((void **)&store->livePos, sizeof(i32), capacity) &&
+            entitystore_grow((void **)&store->generation, sizeof(u32),
+                             capacity) &&
+            entitystore_grow((void **)&store->freeSlots, sizeof(i32),
+                             capacity) &&
+            entitystore_grow((void **)&store->cold, sizeof(Sprite), capacity);
+  for (i32 k = 0; ok && k < ENTITY_KIND_COUNT; ++k)
+    ok = entitystore_grow((void **)&store->live[k], sizeof(i32), capacity);
+  if (!ok)
+    return -1;
+
+  // generations are never reset, so stale handles stay stale across clears
+  memset(store->generation + store->capacity, 0,
+         (size_t)(capacity - store->capacity) * sizeof(u32));
+  store->capacity = capacity;
+  return 0;
+}
+
+void entitystore_clear(EntityStore *store)
+{
+  for (i32 i = 0; i < store->count; ++i)
+  {
+    if (store->livePos[i] >= 0)
+      store->generation[i]++;
+    store->livePos[i] = -1;
+  }
+  memset(store->liveCount, 0, sizeof(store->liveCount));
+  store->freeCount = 0;
+  store->count = 0;
+}
+
+i32 entitystore_spawn(EntityStore *store, SpriteKind kind, f32 x, f32 y,
+                      f32 scale, const Sprite *cold)
+{
+  if (kind < 0 || kind >= ENTITY_KIND_COUNT)
+    return -1;
+
+  i32 index;
+  if (store->freeCount > 0)
+  {
+    index = store->freeSlots[--store->freeCount];
+  }
+  else
+  {
+    if (store->count >= store->capacity &&
+        entitystore_reserve(store, store->capacity
+                                       ? store->capacity * 2
+                                       : ENTITY_INITIAL_CAPACITY) != 0)
+      return -1;
+    index = store->count++;
+  }
+
+  store->x[index] = x;
+  store->y[index] = y;
+  store->scale[index] = scale;
+  store->kind[index] = (u8)kind;
+  store->cold[index] = *cold;
+
+  store->livePos[index] = store->liveCount[kind];
+  store->live[kind][store->liveCount[kind]++] = index;
+  return index;
+}
+
+void entitystore_kill(EntityStore *store, i32 index)
+{
+  if (!entitystore_isLive(store, index))
+    return;
+
+  // the last live entity of the kind takes the freed slot
+  u8 kind = store->kind[index];
+  i32 pos = store->livePos[index];
+  i32 last = store->live[kind][--store->liveCount[kind]];
+  store->live[kind][pos] = last;
+  store->livePos[last] = pos;
+  store->livePos[index] = -1;
+  store->generation[index]++;
+  store->freeSlots[store->freeCount++] = index;
+}
@@ -0,0 +1,93 @@
+#include "flowfield.h"
+
+#define FLOWFIELD_TILES (MAP_WIDTH * MAP_HEIGHT)
+
+// tile index of the next step, -1 for the goal and unreachable tiles
+static i32 g_next[FLOWFIELD_TILES];
+static i32 g_queue[FLOWFIELD_TILES];
+
+static int g_goalX = -1;
+static int g_goalY = -1;
+static u32 g_builtRevision = 0;
+
+static inline int flowfield_index(int x, int y)
+{
+  return x * MAP_HEIGHT + y;
+}
+
+static void flowfield_build(int goalX, int goalY)
+{
+  static const int directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+  for (int i = 0; i < FLOWFIELD_TILES; ++i)
+    g_next[i] = -1;
+
+  g_goalX = goalX;
+  g_goalY = goalY;
+  g_builtRevision = g_mapRevision;
+  if (goalX < 0 || goalX >= MAP_WIDTH || goalY < 0 || goalY >= MAP_HEIGHT)
+    return;
+
+  // the goal marks itself so the search never re-enters it
+  int goal = flowfield_index(goalX, goalY);
+  g_next[goal] = goal;
+  int head = 0;
+  int tail = 0;
+  g_queue[tail++] = goal;
+
+  while (head < tail)
+  {
+    int current = g_queue[head++];
+    int currentX = current / MAP_HEIGHT;
+    int currentY = current % MAP_HEIGHT;
+
+    for (int d = 0; d < 4; ++d)
+    {
+      int nx = currentX + directions[d][0];
+      int ny = currentY + directions[d][1];
+      if (nx < 0 || ny < 0 || nx >= MAP_WIDTH || ny >= MAP_HEIGHT)
+        continue;
+      if (map_isSolid(nx, ny))
+        continue;
+
+      int neighbor = flowfield_index(nx, ny);
+      if (g_next[neighbor] >= 0)
+        continue;
+      g_next[neighbor] = current;
+      g_queue[tail++] = neighbor;
+    }
+  }
+
+  g_next[goal] = -1;
+}
+
+void flowfield_update(int goalX, int goalY)
+{
+  if (goalX == g_goalX && goalY == g_goalY &&
+      g_builtRevision == g_mapRevision)
+    return;
+  flowfield_build(goalX, goalY);
+}
+
+int flowfield_hasGoal(int goalX, int goalY)
+{
+  return goalX == g_goalX && goalY == g_goalY &&
+         g_builtRevision == g_mapRevision;
+}
+
+int flowfield_nextStep(int x, int y, v2i *outNext)
+{
+  if (x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT)
+    return 0;
+
+  int next = g_next[flowfield_index(x, y)];
+  if (next < 0)
+    return 0;
+
+  if (outNext)
+  {
+    outNext->x = next / MAP_HEIGHT;
+    outNext->y = next % MAP_HEIGHT;
+  }
+  return 1;
+}
@@ -0,0 +1,86 @@
+#include "fog.h"
+
+FogState g_fog;
+
+static const f32 g_farPresets[FOG_FAR_PRESETS] = {8.0f, 16.0f, 32.0f, 64.0f};
+
+static void fog_rebuildLUT(void)
+{
+  g_fog.lutScale = (f32)FOG_LUT_SIZE / g_fog.farDistance;
+
+  for (int i = 0; i < FOG_LUT_SIZE; ++i)
+  {
+    if (!g_fog.enabled)
+    {
+      g_fog.weight[i] = 0;
+      continue;
+    }
+
+    // bucket centre, so the ramp is symmetric around start and far
+    f32 distance = ((f32)i + 0.5f) / g_fog.lutScale;
+    f32 t = (distance - g_fog.start) / (g_fog.farDistance - g_fog.start);
+    if (t < 0.0f)
+      t = 0.0f;
+    if (t > 1.0f)
+      t = 1.0f;
+    g_fog.weight[i] = (u16)(t * 256.0f);
+  }
+}
+
+void fog_resetLevelSettings(void)
+{
+  g_fog.enabled = 0;
+  g_fog.start = FOG_DEFAULT_START;
+  g_fog.farDistance = FOG_DEFAULT_FAR;
+  g_fog.maxSteps = FOG_DEFAULT_MAX_STEPS;
+  fog_setColor(FOG_DEFAULT_COLOR);
+  fog_rebuildLUT();
+}
+
+void fog_setEnabled(int enabled)
+{
+  g_fog.enabled = enabled ? 1 : 0;
+  fog_rebuildLUT();
+}
+
+void fog_setRange(f32 start, f32 farDistance)
+{
+  if (farDistance < 1.0f)
+    farDistance = 1.0f;
+  if (start < 0.0f)
+    start = 0.0f;
+  if (start >= farDistance)
+    start = farDistance * 0.5f;
+  g_fog.start = start;
+  g_fog.farDistance = farDistance;
+  fog_rebuildLUT();
+}
+
+void fog_setColor(u32 color)
+{
+  g_fog.color = color | 0xFF000000u;
+  g_fog.pixel = pixel_fromARGB(g_fog.color);
+}
+
+void fog_setMaxSteps(int maxSteps)
+{
+  g_fog.maxSteps = maxSteps < 1 ? 1 : maxSteps;
+}
+
+f32 fog_cycleFarPlane(void)
+{
+  int next = 0;
+  for (int i = 0; i < FOG_FAR_PRESETS; ++i)
+  {
+    if (g_farPresets[i] > g_fog.farDistance)
+    {
+      next = i;
+      break;
+    }
+  }
+
+  // keep the fog band the same fraction of the draw distance
+  f32 fraction = g_fog.start / g_fog.farDistance;
+  fog_setRange(g_farPresets[next] * fraction, g_farPresets[next]);
+  return g_fog.farDistance;
+}
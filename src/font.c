@@ -1,4 +1,5 @@
 #include "font.h"
+#include "blit.h"
 #include "graphics.h"
 #include "types.h"
 
@@ -12,7 +13,7 @@ Font font_init() {
   return f;
 }
 
-void renderText(u32 *buffer, TTF_Font *font, const char *message, int posx,
+void renderText(pixel_t *buffer, TTF_Font *font, const char *message, int posx,
                 int posy, SDL_Color color) {
   // create surface, texture, pos/size
   SDL_Surface *surface = TTF_RenderText_Blended(font, message, color);
@@ -34,54 +35,57 @@ void renderText(u32 *buffer, TTF_Font *font, const char *message, int posx,
     fprintf(stderr, "\033[31m[ERROR] Failed to allocate buffer:  %s\033[0m\n",
             SDL_GetError());
 
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-
-      int screenY = y + posy;
-      int screenX = x + posx;
-
-      if (screenX < 0 || screenX >= RENDER_WIDTH || screenY < 0 ||
-          screenY >= RENDER_HEIGHT) {
-        continue;
-      }
-
-      int image_index = y * (converted->pitch / 4) + x;
-      u32 color = image[image_index];
-
-      if ((color & 0xFF000000) == 0)
-        continue;
-
-      int dstIndex = screenY * RENDER_WIDTH + screenX;
-      buffer[dstIndex] = color;
+  // clip horizontally once, then blit each glyph row with its alpha key
+  int firstX = posx < 0 ? -posx : 0;
+  int lastX = width;
+  if (posx + lastX > RENDER_WIDTH)
+    lastX = RENDER_WIDTH - posx;
+  int count = lastX - firstX;
+
+  for (int y = 0; count > 0 && y < height; y++) {
+    int screenY = y + posy;
+    if (screenY < 0 || screenY >= RENDER_HEIGHT) {
+      continue;
     }
+
+    const u32 *src = image + y * (converted->pitch / 4) + firstX;
+    pixel_t *dst = buffer + screenY * RENDER_WIDTH + posx + firstX;
+#ifdef PIXEL_RGB565
+    pixel_t row[RENDER_WIDTH];
+    for (int x = 0; x < count; x++)
+      row[x] = pixel_fromARGB(src[x]);
+    g_blit.copyKeyed(dst, row, count);
+#else
+    g_blit.copyKeyed(dst, src, count);
+#endif
   }
 
   SDL_FreeSurface(surface);
   SDL_FreeSurface(converted);
 }
 
-void renderf32Pair(u32 *Rbuffer, TTF_Font *font, const char *label, double x,
+void renderf32Pair(pixel_t *Rbuffer, TTF_Font *font, const char *label, double x,
                      double y, int xpos, int ypos, SDL_Color color) {
   char buffer[64];
   snprintf(buffer, sizeof(buffer), "%s %.2f %.2f", label, x, y);
   renderText(Rbuffer, font, buffer, xpos, ypos, color);
 }
 
-void renderInt(u32 *Rbuffer, TTF_Font *font, const char *label, int value,
+void renderInt(pixel_t *Rbuffer, TTF_Font *font, const char *label, int value,
                int x, int y, SDL_Color color) {
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%s %d", label, value);
   renderText(Rbuffer, font, buffer, x, y, color);
 }
 
-void renderf32(u32 *Rbuffer, TTF_Font *font, const char *label, double value,
+void renderf32(pixel_t *Rbuffer, TTF_Font *font, const char *label, double value,
                  int x, int y, SDL_Color color) {
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%s %.2f", label, value);
   renderText(Rbuffer, font, buffer, x, y, color);
 }
 
-void renderProcent(u32 *Rbuffer, TTF_Font *font, int value, int x, int y,
+void renderProcent(pixel_t *Rbuffer, TTF_Font *font, int value, int x, int y,
                    SDL_Color color) {
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%d%%", value);
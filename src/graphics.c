@@ -1,76 +1,68 @@
 #include "graphics.h"
+#include "blit.h"
+#include "postprocess.h"
 #include "types.h"
+#include "upscale.h"
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 Game createGame() {
-  Game g = {NULL,          NULL, NULL, TITLE, WINDOW_WIDTH,
-            WINDOW_HEIGHT, NULL, NULL, NULL};
+  Game g = {NULL,         NULL,          {NULL}, SWAP_DEFAULT, 0,
+            TITLE,        WINDOW_WIDTH,  WINDOW_HEIGHT, NULL, NULL,
+            NULL,         0,             NULL};
   return g;
 }
 
-int buffers_reallocate(Game *game) {
-  free(game->buffer);
-  game->buffer = malloc(game->window_width * game->window_height * sizeof(u32));
-  if (!game->buffer) {
-    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate buffer\033[0m\n");
-    SDL_cleanup(game, EXIT_FAILURE);
-    return 1;
-  }
-  free(game->Rbuffer);
-  game->Rbuffer = malloc(RENDER_WIDTH * RENDER_HEIGHT * sizeof(u32));
-  if (!game->Rbuffer) {
-    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate Rbuffer\033[0m\n");
-    SDL_cleanup(game, EXIT_FAILURE);
-    return 1;
+static void destroyScreenTextures(Game *game) {
+  for (int i = 0; i < SWAP_MAX; i++) {
+    if (game->screen_textures[i]) {
+      SDL_DestroyTexture(game->screen_textures[i]);
+      game->screen_textures[i] = NULL;
+    }
   }
-  free(game->Zbuffer);
-  game->Zbuffer = malloc(RENDER_WIDTH * sizeof(double));
-  if (!game->Zbuffer) {
-    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate Zbuffer\033[0m\n");
-    SDL_cleanup(game, EXIT_FAILURE);
-    return 1;
+}
+
+static int createScreenTextures(Game *game) {
+  // One streaming texture per swap slot, all at RENDER size. The texture we
+  // render into next is never the one that was just handed to the renderer.
+  for (int i = 0; i < game->swapCount; i++) {
+    if (game->screen_textures[i])
+      continue;
+    game->screen_textures[i] = SDL_CreateTexture(
+        game->renderer,
+        PIXEL_SDL_FORMAT, // ARGB8888, or RGB565 in 16 bit builds
+        SDL_TEXTUREACCESS_STREAMING, RENDER_WIDTH, RENDER_HEIGHT);
+    if (!game->screen_textures[i]) {
+      fprintf(stderr, "\033[31m[ERROR] Failed to create texture: %s\033[0m\n",
+              SDL_GetError());
+      return 1;
+    }
   }
   return 0;
 }
 
 void clearBuffer(Game *game) {
-  if (!game || !game->buffer || !game->Rbuffer) {
+  if (!game || !game->Rbuffer) {
     fprintf(stderr,
             "\033[31m[ERROR] clearBuffer called with NULL buffer!\033[0m\n");
     return;
   }
 
-  for (int y = 0; y < RENDER_HEIGHT; y++) {
-    for (int x = 0; x < RENDER_WIDTH; x++) {
-      game->Rbuffer[y * RENDER_WIDTH + x] = 0;
-    }
-  }
-
-  for (int y = 0; y < game->window_height; y++) {
-    for (int x = 0; x < game->window_width; x++) {
-      game->buffer[y * game->window_width + x] = 0;
-    }
-  }
+  // locked texture memory is write-only garbage, so always clear all of it
+  g_blit.clear(game->Rbuffer, 0, RENDER_WIDTH * RENDER_HEIGHT);
 }
 
 int buffers_init(Game *game) {
-  // game pixel buffer (main buffer we draw to)
-  game->buffer = malloc(game->window_width * game->window_height * sizeof(u32));
-  if (!game->buffer) {
-    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate buffer\033[0m");
-    SDL_cleanup(game, EXIT_FAILURE);
-    return 1;
-  }
-
-  // renderBuffer for performance
-  game->Rbuffer = malloc(RENDER_WIDTH * RENDER_HEIGHT * sizeof(u32));
-  if (!game->Rbuffer) {
-    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate Rbuffer\033[0m\n");
+  // fallback render buffer (used when the texture can't be locked directly)
+  game->Fbuffer = malloc(RENDER_WIDTH * RENDER_HEIGHT * sizeof(pixel_t));
+  if (!game->Fbuffer) {
+    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate Fbuffer\033[0m\n");
     SDL_cleanup(game, EXIT_FAILURE);
     return 1;
   }
+  game->Rbuffer = game->Fbuffer;
 
   // Z-index for sprites...
   game->Zbuffer = malloc(RENDER_WIDTH * sizeof(double));
@@ -111,27 +103,37 @@ int SDL_initialize(Game *game) {
     return 1;
   }
 
-  // Create texture for buffer at window size (NOT RENDER SIZE)
-  game->screen_texture = SDL_CreateTexture(
-      game->renderer,
-      SDL_PIXELFORMAT_ARGB8888, // 32-bit color format
-      SDL_TEXTUREACCESS_STREAMING, RENDER_WIDTH, RENDER_HEIGHT);
+  // Create the swap chain textures at RENDER size, the renderer scales them
+  if (createScreenTextures(game))
+    return 1;
 
-  if (!game->screen_texture) {
-    fprintf(stderr, "\033[31m[ERROR] Failed to create texture: %s\033[0m\n",
-            SDL_GetError());
+  return 0;
+}
+
+int graphics_setSwapCount(Game *game, int count) {
+  if (!game || game->texPixels)
     return 1;
+  if (count < 1)
+    count = 1;
+  if (count > SWAP_MAX)
+    count = SWAP_MAX;
+
+  for (int i = count; i < SWAP_MAX; i++) {
+    if (game->screen_textures[i]) {
+      SDL_DestroyTexture(game->screen_textures[i]);
+      game->screen_textures[i] = NULL;
+    }
   }
+  upscale_setSwapCount(count);
 
-  return 0;
+  game->swapCount = count;
+  game->swapIndex %= count;
+  return createScreenTextures(game);
 }
 
 int SDL_cleanup(Game *game, int exit_status) {
   // Destroy textures first (they depend on the renderer)
-  if (game->screen_texture) {
-    SDL_DestroyTexture(game->screen_texture);
-    game->screen_texture = NULL;
-  }
+  destroyScreenTextures(game);
 
   // Then destroy the renderer
   if (game->renderer) {
@@ -149,13 +151,72 @@ int SDL_cleanup(Game *game, int exit_status) {
   return exit_status;
 }
 
+int beginFrame(Game *game) {
+  if (game->texPixels)
+    return 0;
+
+  // the upscaler reads the frame back, so keep it in ordinary memory
+  if (upscale_isActive()) {
+    game->Rbuffer = game->Fbuffer;
+    return 0;
+  }
+
+  /* Lock the next texture in the swap chain and hand its memory to the
+   * renderer as Rbuffer, so the frame is drawn straight into the texture and
+   * drawBuffer doesn't have to copy it. Everything indexes Rbuffer with
+   * RENDER_WIDTH as stride, so if the driver pads the rows we draw into the
+   * fallback buffer instead and copy row by row on unlock. */
+  SDL_Texture *target = game->screen_textures[game->swapIndex];
+  void *pixels = NULL;
+  int pitch = 0;
+  if (!target || SDL_LockTexture(target, NULL, &pixels, &pitch) != 0) {
+    fprintf(stderr, "\033[31m[ERROR] Failed to lock texture: %s\033[0m\n",
+            SDL_GetError());
+    game->Rbuffer = game->Fbuffer;
+    return 1;
+  }
+
+  game->texPixels = pixels;
+  game->texPitch = pitch;
+  // reading write-combined memory back is uncached, so the colour grade
+  // works on the fallback buffer and the frame is copied up once at the end
+  if (pitch == RENDER_WIDTH * (int)sizeof(pixel_t) && !post_readsFrame())
+    game->Rbuffer = (pixel_t *)pixels;
+  else
+    game->Rbuffer = game->Fbuffer;
+  return 0;
+}
+
 void drawBuffer(Game *game) {
-  // Update texture with buffer data
-  SDL_UpdateTexture(game->screen_texture,
-                    NULL, // Update entire texture
-                    game->Rbuffer,
-                    RENDER_WIDTH * sizeof(u32) // Pitch (bytes per row)
-  );
+  SDL_Texture *target = game->screen_textures[game->swapIndex];
+
+  // scale into a window sized texture ourselves instead of SDL stretching
+  if (!game->texPixels && upscale_isActive() && upscale_present(game) == 0) {
+    game->swapIndex = (game->swapIndex + 1) % game->swapCount;
+    return;
+  }
+
+  if (game->texPixels) {
+    // drawn into the fallback buffer, copy its rows into the texture rows
+    if (game->Rbuffer == game->Fbuffer) {
+      Uint8 *dst = (Uint8 *)game->texPixels;
+      for (int y = 0; y < RENDER_HEIGHT; y++)
+        memcpy(dst + (size_t)y * game->texPitch,
+               game->Fbuffer + (size_t)y * RENDER_WIDTH,
+               RENDER_WIDTH * sizeof(pixel_t));
+    }
+    SDL_UnlockTexture(target);
+    game->texPixels = NULL;
+  } else {
+    // texture couldn't be locked, upload the fallback buffer the slow way
+    SDL_UpdateTexture(target,
+                      NULL, // Update entire texture
+                      game->Fbuffer,
+                      RENDER_WIDTH * sizeof(pixel_t) // Pitch (bytes per row)
+    );
+  }
+  // nothing may draw into the texture memory after it has been unlocked
+  game->Rbuffer = game->Fbuffer;
 
   /* Here we use Rbuffer (low res) to create the texture, then create a
    * rectangle and the top left of the screen (0, 0) and with the size of
@@ -163,5 +224,8 @@ void drawBuffer(Game *game) {
    * By passing in a Rect, SDL will automatically scale the texture to the Rect
    * which has the size of the window */
   SDL_Rect dstRect = {0, 0, game->window_width, game->window_height};
-  SDL_RenderCopy(game->renderer, game->screen_texture, NULL, &dstRect);
+  SDL_RenderCopy(game->renderer, target, NULL, &dstRect);
+
+  // next frame renders into the next texture while this one is scanned out
+  game->swapIndex = (game->swapIndex + 1) % game->swapCount;
 }
@@ -1,9 +1,13 @@
 #include "input.h"
 #include "animation.h"
+#include "automap.h"
 #include "player.h"
 #include "enemies.h"
 #include "weapons.h"
 #include "entities.h"
+#include "fog.h"
+#include "postprocess.h"
+#include "upscale.h"
 
 int mouseUngrabbed = 0;
 
@@ -25,26 +29,8 @@ int handleInput(Engine *engine, double deltaTime) {
       engine->game.window_width = event.window.data1;
       engine->game.window_height = event.window.data2;
 
-      // Reallocate buffers
-      buffers_reallocate(&engine->game);
-
-      // Recreate texture with new dimensions
-      if (engine->game.screen_texture) {
-        SDL_DestroyTexture(engine->game.screen_texture);
-      }
-
-      engine->game.screen_texture = SDL_CreateTexture(
-          engine->game.renderer, SDL_PIXELFORMAT_ARGB8888,
-          SDL_TEXTUREACCESS_STREAMING, RENDER_WIDTH, RENDER_HEIGHT);
-
-      if (!engine->game.screen_texture) {
-        fprintf(stderr,
-                "\033[31m[ERROR] Failed to recreate texture: %s\033[0m\n",
-                SDL_GetError());
-        engine_cleanup(engine, EXIT_FAILURE);
-        return 1;
-      }
-
+      // Nothing to reallocate: we render at RENDER size and the renderer
+      // scales the swap chain texture to the window in drawBuffer
       printf("\033[32m[WINDOW] Window resized to %dx%d\033[0m\n",
              engine->game.window_width, engine->game.window_height);
     }
@@ -92,6 +78,44 @@ int handleInput(Engine *engine, double deltaTime) {
         }
       }
 
+      // Double / triple buffered present
+      if (event.key.keysym.scancode == TOGGLE_TRIPLE_BUFFER) {
+        int count = (engine->game.swapCount == SWAP_TRIPLE) ? SWAP_DOUBLE
+                                                             : SWAP_TRIPLE;
+        if (graphics_setSwapCount(&engine->game, count) == 0)
+          printf("\033[35m[PRESENT] Swap chain: %d textures\033[0m\n", count);
+      }
+
+      // Present upscale filter
+      if (event.key.keysym.scancode == CYCLE_UPSCALE) {
+        upscale_setFilter((upscale_getFilter() + 1) % UPSCALE_TOTAL);
+        printf("\033[35m[UPSCALE] Filter: %s\033[0m\n",
+               upscale_filterName(upscale_getFilter()));
+      }
+
+      if (event.key.keysym.scancode == TOGGLE_POST) {
+        post_setEnabled(!post_isEnabled());
+        printf("\033[35m[POST] Post-process: %s\033[0m\n",
+               post_isEnabled() ? "ON" : "OFF");
+      }
+
+      if (event.key.keysym.scancode == TOGGLE_FOG) {
+        fog_setEnabled(!g_fog.enabled);
+        printf("\033[35m[FOG] Distance fog: %s\033[0m\n",
+               g_fog.enabled ? "ON" : "OFF");
+      }
+
+      if (event.key.keysym.scancode == CYCLE_DRAW_DISTANCE) {
+        printf("\033[35m[FOG] Draw distance: %.0f\033[0m\n",
+               fog_cycleFarPlane());
+      }
+
+      if (event.key.keysym.scancode == TOGGLE_AUTOMAP) {
+        automap_setEnabled(!automap_isEnabled());
+        printf("\033[35m[AUTOMAP] Automap: %s\033[0m\n",
+               automap_isEnabled() ? "ON" : "OFF");
+      }
+
       // Reload
       /* if (event.key.keysym.scancode == GUN_RELOAD) { */
       /*   playShotgunReload(&engine->sound); */
@@ -141,7 +165,7 @@ int handleInput(Engine *engine, double deltaTime) {
               animations.shotgun_shoot.playing = 1;
               playShotgunShot(&engine->sound);
               enemies_applyHitscanDamage(
-                  engine, weaponProperties[engine->player.selectedGun].damage);
+                  engine, &weaponProperties[engine->player.selectedGun]);
             }
             break;
           case ROCKET:
@@ -150,7 +174,7 @@ int handleInput(Engine *engine, double deltaTime) {
               animations.rocket_shoot.playing = 1;
               playRocketShot(&engine->sound);
               enemies_applyHitscanDamage(
-                  engine, weaponProperties[engine->player.selectedGun].damage);
+                  engine, &weaponProperties[engine->player.selectedGun]);
             }
             break;
           case PISTOL:
@@ -159,7 +183,7 @@ int handleInput(Engine *engine, double deltaTime) {
               weaponProperties[engine->player.selectedGun].ammunition--;
               playPistolShot(&engine->sound);
               enemies_applyHitscanDamage(
-                  engine, weaponProperties[engine->player.selectedGun].damage);
+                  engine, &weaponProperties[engine->player.selectedGun]);
             }
             break;
           /* case HANDS: */
@@ -174,7 +198,7 @@ int handleInput(Engine *engine, double deltaTime) {
               weaponProperties[engine->player.selectedGun].ammunition--;
               playSingleShot(&engine->sound);
               enemies_applyHitscanDamage(
-                  engine, weaponProperties[engine->player.selectedGun].damage);
+                  engine, &weaponProperties[engine->player.selectedGun]);
             }
             break;
           case MINIGUN:
@@ -183,7 +207,7 @@ int handleInput(Engine *engine, double deltaTime) {
               weaponProperties[engine->player.selectedGun].ammunition--;
               playMinigunShot(&engine->sound);
               enemies_applyHitscanDamage(
-                  engine, weaponProperties[engine->player.selectedGun].damage);
+                  engine, &weaponProperties[engine->player.selectedGun]);
             }
             break;
           default:
@@ -217,9 +241,7 @@ int handleInput(Engine *engine, double deltaTime) {
         default:
           break;
         }
-        enemies_applyHitscanDamage(engine,
-                                   weaponProperties[engine->player.selectedGun]
-                                       .damage);
+        enemies_applyHitscanDamage(engine, weapon);
       }
     }
   } else {
@@ -229,18 +251,18 @@ int handleInput(Engine *engine, double deltaTime) {
 
   /* CONTINUOUS INPUT (held keys) */
   const Uint8 *state = SDL_GetKeyboardState(NULL);
-  Sprite *sprites = engine->sprites;
-  int spriteCount = entities_getSpriteCount();
+  const EntityStore *entities = engine->entities;
+  const SpatialGrid *spriteGrid = entities_getSpriteGrid();
 
   // Movement
   if (state[SDL_SCANCODE_W] || state[SDL_SCANCODE_UP])
-    player_move(&engine->player, deltaTime, worldMap, sprites, spriteCount, 1);
+    player_move(&engine->player, deltaTime, entities, spriteGrid, 1);
   if (state[SDL_SCANCODE_S] || state[SDL_SCANCODE_DOWN])
-    player_move(&engine->player, deltaTime, worldMap, sprites, spriteCount, -1);
+    player_move(&engine->player, deltaTime, entities, spriteGrid, -1);
   if (state[SDL_SCANCODE_A])
-    player_strafe(&engine->player, deltaTime, worldMap, sprites, spriteCount, -1);
+    player_strafe(&engine->player, deltaTime, entities, spriteGrid, -1);
   if (state[SDL_SCANCODE_D])
-    player_strafe(&engine->player, deltaTime, worldMap, sprites, spriteCount, 1);
+    player_strafe(&engine->player, deltaTime, entities, spriteGrid, 1);
 
   // Rotation with keys
   if (state[SDL_SCANCODE_LEFT])
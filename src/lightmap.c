@@ -0,0 +1,332 @@
+#include "lightmap.h"
+#include "map.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LIGHT_SAMPLES (LIGHT_FACE_RES * LIGHT_FACE_RES)
+
+typedef struct
+{
+  f32 x;
+  f32 y;
+} LightSource;
+
+#ifdef PIXEL_RGB565
+u8 g_lightShade5[LIGHT_LEVELS][32];
+u8 g_lightShade6[LIGHT_LEVELS][64];
+#else
+u8 g_lightShade[LIGHT_LEVELS][256];
+#endif
+
+static LightSource g_lights[LIGHT_MAX_SOURCES];
+static int g_lightCount = 0;
+
+// face order: -x, +x, -y, +y (direction from the wall towards the viewer)
+static u8 g_wallLight[MAP_WIDTH][MAP_HEIGHT][4][LIGHT_SAMPLES];
+static u8 g_floorLight[MAP_WIDTH][MAP_HEIGHT][LIGHT_SAMPLES];
+static u8 g_ceilingLight[MAP_WIDTH][MAP_HEIGHT][LIGHT_SAMPLES];
+static u8 g_ambientTile[LIGHT_SAMPLES];
+
+static const int g_faceDir[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+static int lightmap_faceIndex(int faceX, int faceY)
+{
+  if (faceX != 0)
+    return faceX < 0 ? 0 : 1;
+  return faceY < 0 ? 2 : 3;
+}
+
+static int lightmap_isSolid(int x, int y)
+{
+  if (x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT)
+    return 1;
+  return map_isSolid(x, y);
+}
+
+static void lightmap_fillShadeRow(u8 *row, int size, int level)
+{
+  for (int c = 0; c < size; ++c)
+  {
+    int value = c * level / LIGHT_LEVEL_ONE;
+    row[c] = (u8)(value > size - 1 ? size - 1 : value);
+  }
+}
+
+static void lightmap_buildShadeLUT(void)
+{
+  for (int level = 0; level < LIGHT_LEVELS; ++level)
+  {
+#ifdef PIXEL_RGB565
+    lightmap_fillShadeRow(g_lightShade5[level], 32, level);
+    lightmap_fillShadeRow(g_lightShade6[level], 64, level);
+#else
+    lightmap_fillShadeRow(g_lightShade[level], 256, level);
+#endif
+  }
+}
+
+// 2D DDA from the light to the sample, blocked by any solid tile on the way
+int lightmap_traceVisible(f32 fromX, f32 fromY, f32 toX, f32 toY)
+{
+  int mapX = (int)fromX;
+  int mapY = (int)fromY;
+  const int endX = (int)toX;
+  const int endY = (int)toY;
+
+  f32 dirX = toX - fromX;
+  f32 dirY = toY - fromY;
+  f32 deltaDistX = (dirX == 0.0f) ? 1e30f : fabsf(1.0f / dirX);
+  f32 deltaDistY = (dirY == 0.0f) ? 1e30f : fabsf(1.0f / dirY);
+  int stepX = (dirX < 0.0f) ? -1 : 1;
+  int stepY = (dirY < 0.0f) ? -1 : 1;
+  f32 sideDistX = (dirX < 0.0f) ? (fromX - mapX) * deltaDistX
+                                : (mapX + 1.0f - fromX) * deltaDistX;
+  f32 sideDistY = (dirY < 0.0f) ? (fromY - mapY) * deltaDistY
+                                : (mapY + 1.0f - fromY) * deltaDistY;
+
+  while (mapX != endX || mapY != endY)
+  {
+    if (sideDistX < sideDistY)
+    {
+      if (sideDistX > 1.0f)
+        break;
+      sideDistX += deltaDistX;
+      mapX += stepX;
+    }
+    else
+    {
+      if (sideDistY > 1.0f)
+        break;
+      sideDistY += deltaDistY;
+      mapY += stepY;
+    }
+
+    if (lightmap_isSolid(mapX, mapY))
+      return 0;
+  }
+  return 1;
+}
+
+/* Sums every light reaching a point with normal (nx, ny, nz) on top of the
+ * ambient level and returns the quantized shade level. */
+static u8 lightmap_evaluate(f32 px, f32 py, f32 pz, f32 nx, f32 ny, f32 nz,
+                            int ambient)
+{
+  f32 level = (f32)ambient;
+
+  for (int i = 0; i < g_lightCount; ++i)
+  {
+    f32 dx = g_lights[i].x - px;
+    f32 dy = g_lights[i].y - py;
+    f32 dz = LIGHT_BAKE_HEIGHT - pz;
+    f32 dist = sqrtf(dx * dx + dy * dy + dz * dz);
+    if (dist >= LIGHT_BAKE_RADIUS || dist <= 0.0f)
+      continue;
+
+    f32 lambert = (dx * nx + dy * ny + dz * nz) / dist;
+    if (lambert <= 0.0f)
+      continue;
+    if (!lightmap_traceVisible(g_lights[i].x, g_lights[i].y, px, py))
+      continue;
+
+    f32 falloff = 1.0f - dist / LIGHT_BAKE_RADIUS;
+    level += LIGHT_BAKE_INTENSITY * lambert * falloff * falloff;
+  }
+
+  if (level > (f32)(LIGHT_LEVELS - 1))
+    level = (f32)(LIGHT_LEVELS - 1);
+  return (u8)(level + 0.5f);
+}
+
+static void lightmap_bakeTile(int x, int y)
+{
+  const f32 cell = 1.0f / (f32)LIGHT_FACE_RES;
+  // keeps wall samples just inside the open neighbour tile
+  const f32 surfaceOffset = 0.001f;
+
+  if (!lightmap_isSolid(x, y))
+  {
+    for (int row = 0; row < LIGHT_FACE_RES; ++row)
+    {
+      for (int col = 0; col < LIGHT_FACE_RES; ++col)
+      {
+        f32 px = (f32)x + ((f32)col + 0.5f) * cell;
+        f32 py = (f32)y + ((f32)row + 0.5f) * cell;
+        int i = row * LIGHT_FACE_RES + col;
+        g_floorLight[x][y][i] =
+            lightmap_evaluate(px, py, 0.0f, 0.0f, 0.0f, 1.0f,
+                              LIGHT_AMBIENT_FLOOR);
+        g_ceilingLight[x][y][i] =
+            lightmap_evaluate(px, py, 1.0f, 0.0f, 0.0f, -1.0f,
+                              LIGHT_AMBIENT_FLOOR);
+      }
+    }
+    return;
+  }
+
+  for (int face = 0; face < 4; ++face)
+  {
+    int fx = g_faceDir[face][0];
+    int fy = g_faceDir[face][1];
+    int ambient = fx != 0 ? LIGHT_AMBIENT_WALL_X : LIGHT_AMBIENT_WALL_Y;
+    u8 *samples = g_wallLight[x][y][face];
+
+    if (lightmap_isSolid(x + fx, y + fy))
+    {
+      for (int i = 0; i < LIGHT_SAMPLES; ++i)
+        samples[i] = (u8)ambient;
+      continue;
+    }
+
+    for (int row = 0; row < LIGHT_FACE_RES; ++row)
+    {
+      f32 pz = 1.0f - ((f32)row + 0.5f) * cell;
+      for (int col = 0; col < LIGHT_FACE_RES; ++col)
+      {
+        f32 along = ((f32)col + 0.5f) * cell;
+        f32 px, py;
+        if (fx != 0)
+        {
+          px = fx < 0 ? (f32)x - surfaceOffset : (f32)(x + 1) + surfaceOffset;
+          py = (f32)y + along;
+        }
+        else
+        {
+          px = (f32)x + along;
+          py = fy < 0 ? (f32)y - surfaceOffset : (f32)(y + 1) + surfaceOffset;
+        }
+        samples[row * LIGHT_FACE_RES + col] = lightmap_evaluate(
+            px, py, pz, (f32)fx, (f32)fy, 0.0f, ambient);
+      }
+    }
+  }
+}
+
+static void lightmap_bakeRegion(int x0, int y0, int x1, int y1)
+{
+  if (x0 < 0)
+    x0 = 0;
+  if (y0 < 0)
+    y0 = 0;
+  if (x1 >= MAP_WIDTH)
+    x1 = MAP_WIDTH - 1;
+  if (y1 >= MAP_HEIGHT)
+    y1 = MAP_HEIGHT - 1;
+
+  for (int x = x0; x <= x1; ++x)
+    for (int y = y0; y <= y1; ++y)
+      lightmap_bakeTile(x, y);
+}
+
+void lightmap_build(const EntityStore *entities)
+{
+  lightmap_buildShadeLUT();
+  for (int i = 0; i < LIGHT_SAMPLES; ++i)
+    g_ambientTile[i] = LIGHT_AMBIENT_FLOOR;
+
+  g_lightCount = 0;
+  i32 count = entities ? entities->liveCount[SPRITE_DECORATION] : 0;
+  for (i32 n = 0; n < count; ++n)
+  {
+    i32 i = entities->live[SPRITE_DECORATION][n];
+    const Sprite *sprite = &entities->cold[i];
+    if (sprite->appearance.type != SPRITE_VISUAL_TEXTURE ||
+        sprite->appearance.texture.textureId != TEX_GREENLIGHT)
+      continue;
+    if (lightmap_isSolid((int)entities->x[i], (int)entities->y[i]))
+      continue;
+    if (g_lightCount >= LIGHT_MAX_SOURCES)
+    {
+      fprintf(stderr,
+              "\033[33m[WARN] Light limit reached (%d), ignoring the rest\033[0m\n",
+              LIGHT_MAX_SOURCES);
+      break;
+    }
+    g_lights[g_lightCount].x = entities->x[i];
+    g_lights[g_lightCount].y = entities->y[i];
+    g_lightCount++;
+  }
+
+  Uint32 start = SDL_GetTicks();
+  lightmap_bakeRegion(0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1);
+  printf("\033[32m[LIGHT] Baked %d lights in %u ms\033[0m\n", g_lightCount,
+         SDL_GetTicks() - start);
+}
+
+// squared distance from a point to the square of a tile, 0 inside it
+static f32 lightmap_tileDistance2(f32 px, f32 py, int tileX, int tileY)
+{
+  f32 cx = px < (f32)tileX ? (f32)tileX
+                           : (px > (f32)(tileX + 1) ? (f32)(tileX + 1) : px);
+  f32 cy = py < (f32)tileY ? (f32)tileY
+                           : (py > (f32)(tileY + 1) ? (f32)(tileY + 1) : py);
+  return (px - cx) * (px - cx) + (py - cy) * (py - cy);
+}
+
+void lightmap_onTileChanged(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return;
+
+  /* A tile only shadows samples of lights whose radius covers it, and those
+   * samples lie within the radius of the light. Wall samples sit a hair
+   * outside their tile, hence the small margin. */
+  static u8 rebake[MAP_WIDTH][MAP_HEIGHT];
+  memset(rebake, 0, sizeof(rebake));
+  const f32 radius2 = LIGHT_BAKE_RADIUS * LIGHT_BAKE_RADIUS;
+  const f32 reach = LIGHT_BAKE_RADIUS + 0.01f;
+  for (int i = 0; i < g_lightCount; ++i)
+  {
+    f32 lx = g_lights[i].x;
+    f32 ly = g_lights[i].y;
+    if (lightmap_tileDistance2(lx, ly, tileX, tileY) >= radius2)
+      continue;
+
+    int x0 = (int)floorf(lx - reach);
+    int x1 = (int)floorf(lx + reach);
+    int y0 = (int)floorf(ly - reach);
+    int y1 = (int)floorf(ly + reach);
+    for (int x = x0 < 0 ? 0 : x0; x <= x1 && x < MAP_WIDTH; ++x)
+      for (int y = y0 < 0 ? 0 : y0; y <= y1 && y < MAP_HEIGHT; ++y)
+        if (lightmap_tileDistance2(lx, ly, x, y) < reach * reach)
+          rebake[x][y] = 1;
+  }
+
+  // the tile itself and the faces of its neighbours that look at it
+  rebake[tileX][tileY] = 1;
+  for (int face = 0; face < 4; ++face)
+  {
+    int nx = tileX + g_faceDir[face][0];
+    int ny = tileY + g_faceDir[face][1];
+    if (nx >= 0 && nx < MAP_WIDTH && ny >= 0 && ny < MAP_HEIGHT)
+      rebake[nx][ny] = 1;
+  }
+
+  for (int x = 0; x < MAP_WIDTH; ++x)
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+      if (rebake[x][y])
+        lightmap_bakeTile(x, y);
+}
+
+const u8 *lightmap_wallFace(int tileX, int tileY, int faceX, int faceY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return g_ambientTile;
+  return g_wallLight[tileX][tileY][lightmap_faceIndex(faceX, faceY)];
+}
+
+const u8 *lightmap_floorTile(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return g_ambientTile;
+  return g_floorLight[tileX][tileY];
+}
+
+const u8 *lightmap_ceilingTile(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return g_ambientTile;
+  return g_ceilingLight[tileX][tileY];
+}
@@ -1,9 +1,11 @@
+#include "dynlight.h"
 #include "engine.h"
 #include "graphics.h"
 #include "input.h"
 #include "enemies.h"
 #include "raycast.h"
 #include "render.h"
+#include "texcache.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,7 +25,9 @@ int main()
     handleInput(&engine, engine.deltaTime);
 
     enemies_update(&engine, engine.deltaTime);
+    dynlight_update(engine.deltaTime);
     updateAllAnimations(&engine.player, engine.deltaTime);
+    texcache_update();
     drawScene(&engine);
     SDL_RenderPresent(engine.game.renderer);
   }
@@ -34,10 +34,54 @@ static const int defaultMap[MAP_WIDTH][MAP_HEIGHT] = {
 
 static int mapInitialized = 0;
 int worldMap[MAP_WIDTH][MAP_HEIGHT];
+u32 g_solidColumns[MAP_WIDTH][MAP_SOLID_WORDS_Y];
+u32 g_solidRows[MAP_HEIGHT][MAP_SOLID_WORDS_X];
+u32 g_mapRevision = 0;
+
+static void map_writeSolidBit(int x, int y, int solid)
+{
+  u32 columnBit = 1u << (y & 31);
+  u32 rowBit = 1u << (x & 31);
+  if (solid)
+  {
+    g_solidColumns[x][y >> 5] |= columnBit;
+    g_solidRows[y][x >> 5] |= rowBit;
+  }
+  else
+  {
+    g_solidColumns[x][y >> 5] &= ~columnBit;
+    g_solidRows[y][x >> 5] &= ~rowBit;
+  }
+}
+
+void map_syncSolidity(void)
+{
+  memset(g_solidColumns, 0, sizeof(g_solidColumns));
+  memset(g_solidRows, 0, sizeof(g_solidRows));
+  for (int x = 0; x < MAP_WIDTH; ++x)
+  {
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+    {
+      if (worldMap[x][y] > 0)
+        map_writeSolidBit(x, y, 1);
+    }
+  }
+  g_mapRevision++;
+}
+
+void map_setTile(int x, int y, int value)
+{
+  if (x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT)
+    return;
+  worldMap[x][y] = value;
+  map_writeSolidBit(x, y, value > 0);
+  g_mapRevision++;
+}
 
 static void map_applyDefault(void)
 {
   memcpy(worldMap, defaultMap, sizeof(worldMap));
+  map_syncSolidity();
   mapInitialized = 1;
 }
 
@@ -131,5 +175,6 @@ int map_loadFromCSV(const char *filepath)
   }
 
   fclose(file);
+  map_syncSolidity();
   return 0;
 }
@@ -0,0 +1,108 @@
+#include "mip.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int mip_isTransparent(pixel_t p, MipKey key)
+{
+  return key == MIP_KEY_ALPHA ? !pixel_isOpaque(p) : pixel_isColorKey(p);
+}
+
+static void mip_downsample(pixel_t *dst, i32 dstW, i32 dstH,
+                           const pixel_t *src, i32 srcW, i32 srcH, MipKey key)
+{
+  for (i32 y = 0; y < dstH; ++y)
+  {
+    i32 y0 = y * 2;
+    i32 y1 = (y0 + 1 < srcH) ? y0 + 1 : y0;
+    for (i32 x = 0; x < dstW; ++x)
+    {
+      i32 x0 = x * 2;
+      i32 x1 = (x0 + 1 < srcW) ? x0 + 1 : x0;
+      pixel_t taps[4] = {src[y0 * srcW + x0], src[y0 * srcW + x1],
+                         src[y1 * srcW + x0], src[y1 * srcW + x1]};
+
+      u32 r = 0, g = 0, b = 0, opaque = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        if (mip_isTransparent(taps[i], key))
+          continue;
+        u32 c = pixel_toARGB(taps[i]);
+        r += (c >> 16) & 0xFFu;
+        g += (c >> 8) & 0xFFu;
+        b += c & 0xFFu;
+        ++opaque;
+      }
+
+      if (opaque < 2)
+      {
+        dst[y * dstW + x] = pixel_fromARGB(0);
+        continue;
+      }
+
+      r = (r + opaque / 2) / opaque;
+      g = (g + opaque / 2) / opaque;
+      b = (b + opaque / 2) / opaque;
+      pixel_t out = pixel_fromARGB(0xFF000000u | (r << 16) | (g << 8) | b);
+      // an average of dark texels must not turn into the colour key
+      if (mip_isTransparent(out, key))
+        out = pixel_fromARGB(0xFF080808u);
+      dst[y * dstW + x] = out;
+    }
+  }
+}
+
+int mip_build(MipChain *chain, const pixel_t *base, i32 width, i32 height,
+              MipKey key)
+{
+  memset(chain, 0, sizeof(*chain));
+  chain->pixels[0] = base;
+  chain->width[0] = width;
+  chain->height[0] = height;
+  chain->levels = 1;
+  if (!base || width <= 0 || height <= 0)
+    return 1;
+
+  size_t total = 0;
+  i32 levels = 1;
+  for (i32 w = width, h = height;
+       levels < MIP_MAX_LEVELS && (w > 1 || h > 1); ++levels)
+  {
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+    total += (size_t)w * (size_t)h;
+  }
+  if (levels == 1)
+    return 0;
+
+  chain->storage = malloc(total * sizeof(pixel_t));
+  if (!chain->storage)
+  {
+    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate mip chain\033[0m\n");
+    return 1;
+  }
+
+  pixel_t *next = chain->storage;
+  for (i32 level = 1; level < levels; ++level)
+  {
+    i32 srcW = chain->width[level - 1];
+    i32 srcH = chain->height[level - 1];
+    i32 w = srcW > 1 ? srcW / 2 : 1;
+    i32 h = srcH > 1 ? srcH / 2 : 1;
+    mip_downsample(next, w, h, chain->pixels[level - 1], srcW, srcH, key);
+    chain->pixels[level] = next;
+    chain->width[level] = w;
+    chain->height[level] = h;
+    next += (size_t)w * (size_t)h;
+  }
+  chain->levels = levels;
+  return 0;
+}
+
+void mip_free(MipChain *chain)
+{
+  if (!chain)
+    return;
+  free(chain->storage);
+  memset(chain, 0, sizeof(*chain));
+}
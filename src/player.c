@@ -1,24 +1,36 @@
 #include "player.h"
+#include "entitystore.h"
 #include "map.h"
-#include "sprites.h"
+#include "spatialgrid.h"
 #include <stdbool.h>
 #include <math.h>
 
-static bool player_overlaps_enemy(f64 x, f64 y, Sprite *sprites,
-                                  int spriteCount)
+// enemies are looked up this far around the player, enough up to scale 4
+#define PLAYER_ENEMY_QUERY_RADIUS 1.25
+
+static bool player_overlaps_enemy(f64 x, f64 y,
+                                  const EntityStore *entities,
+                                  const SpatialGrid *grid)
 {
   const double playerRadius = 0.23;
   const double enemyBaseRadius = 0.25;
 
-  for (int i = 0; i < spriteCount; ++i)
+  if (!entities || !grid)
+    return false;
+
+  i32 nearby[64];
+  i32 nearbyCount = spatialgrid_queryRadius(
+      grid, x, y, PLAYER_ENEMY_QUERY_RADIUS, nearby, 64);
+  for (i32 n = 0; n < nearbyCount; ++n)
   {
-    Sprite *sprite = &sprites[i];
-    if (!sprite->active || sprite->kind != SPRITE_ENEMY || sprite->health <= 0)
+    // only live sprites are in the grid, and enemies die as they hit 0 health
+    i32 i = nearby[n];
+    if (entities->kind[i] != SPRITE_ENEMY)
       continue;
 
-    double dx = sprite->x - x;
-    double dy = sprite->y - y;
-    double enemyRadius = enemyBaseRadius * sprite->scale;
+    double dx = entities->x[i] - x;
+    double dy = entities->y[i] - y;
+    double enemyRadius = enemyBaseRadius * entities->scale[i];
     double minDistance = playerRadius + enemyRadius;
     double minDistanceSq = minDistance * minDistance;
 
@@ -37,36 +49,36 @@ Player createPlayer() {
 }
 
 void player_move(Player *player, double deltaTime,
-                 int worldMap[MAP_HEIGHT][MAP_WIDTH], Sprite *sprites,
-                 int spriteCount, int direction) {
+                 const EntityStore *entities, const SpatialGrid *grid,
+                 int direction) {
   double moveStep = player->moveSpeed * deltaTime * direction;
 
   double newX = player->posX + player->dirX * moveStep;
   double newY = player->posY + player->dirY * moveStep;
 
   // collision check
-  if (!worldMap[(int)newX][(int)player->posY] &&
-      !player_overlaps_enemy(newX, player->posY, sprites, spriteCount))
+  if (!map_isSolid((int)newX, (int)player->posY) &&
+      !player_overlaps_enemy(newX, player->posY, entities, grid))
     player->posX = newX;
-  if (!worldMap[(int)player->posX][(int)newY] &&
-      !player_overlaps_enemy(player->posX, newY, sprites, spriteCount))
+  if (!map_isSolid((int)player->posX, (int)newY) &&
+      !player_overlaps_enemy(player->posX, newY, entities, grid))
     player->posY = newY;
 }
 
 void player_strafe(Player *player, double deltaTime,
-                   int worldMap[MAP_HEIGHT][MAP_WIDTH], Sprite *sprites,
-                   int spriteCount, int direction) {
+                   const EntityStore *entities, const SpatialGrid *grid,
+                   int direction) {
   double moveStep = player->moveSpeed * deltaTime * direction;
 
   double newX = player->posX + player->planeX * moveStep;
   double newY = player->posY + player->planeY * moveStep;
 
   // collision check
-  if (!worldMap[(int)newX][(int)player->posY] &&
-      !player_overlaps_enemy(newX, player->posY, sprites, spriteCount))
+  if (!map_isSolid((int)newX, (int)player->posY) &&
+      !player_overlaps_enemy(newX, player->posY, entities, grid))
     player->posX = newX;
-  if (!worldMap[(int)player->posX][(int)newY] &&
-      !player_overlaps_enemy(player->posX, newY, sprites, spriteCount))
+  if (!map_isSolid((int)player->posX, (int)newY) &&
+      !player_overlaps_enemy(player->posX, newY, entities, grid))
     player->posY = newY;
 }
 
@@ -0,0 +1,202 @@
+#include "postprocess.h"
+#include "blit.h"
+#include "engine.h"
+#include "threads.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+  int enabled;
+  pixel_t *lut; // POST_LUT_ENTRIES, red fastest, NULL = identity
+} PostState;
+
+typedef struct
+{
+  pixel_t *buffer;
+  const pixel_t *lut;
+} PostJob;
+
+static PostState g_post = {0, NULL};
+
+static void post_rows(void *ctx, int begin, int end)
+{
+  const PostJob *job = (const PostJob *)ctx;
+  const pixel_t *lut = job->lut;
+
+  // the rows are contiguous, one kernel call covers the whole band
+  g_blit.gradeLUT(job->buffer + begin * RENDER_WIDTH, lut, POST_LUT_BITS,
+                  (end - begin) * RENDER_WIDTH);
+}
+
+void post_apply(Engine *engine)
+{
+  if (!g_post.enabled || !g_post.lut || !engine || !engine->game.Rbuffer)
+    return;
+
+  PostJob job;
+  job.buffer = engine->game.Rbuffer;
+  job.lut = g_post.lut;
+  threads_parallelFor(RENDER_HEIGHT, post_rows, &job);
+}
+
+static f32 post_sampleCube(const f32 *cube, int size, f32 r, f32 g, f32 b,
+                           int channel)
+{
+  f32 fr = r * (f32)(size - 1);
+  f32 fg = g * (f32)(size - 1);
+  f32 fb = b * (f32)(size - 1);
+  int r0 = (int)fr;
+  int g0 = (int)fg;
+  int b0 = (int)fb;
+  int r1 = (r0 + 1 < size) ? r0 + 1 : r0;
+  int g1 = (g0 + 1 < size) ? g0 + 1 : g0;
+  int b1 = (b0 + 1 < size) ? b0 + 1 : b0;
+  fr -= (f32)r0;
+  fg -= (f32)g0;
+  fb -= (f32)b0;
+
+#define CUBE(R, G, B) cube[(((B) * size + (G)) * size + (R)) * 3 + channel]
+  f32 c00 = CUBE(r0, g0, b0) + (CUBE(r1, g0, b0) - CUBE(r0, g0, b0)) * fr;
+  f32 c10 = CUBE(r0, g1, b0) + (CUBE(r1, g1, b0) - CUBE(r0, g1, b0)) * fr;
+  f32 c01 = CUBE(r0, g0, b1) + (CUBE(r1, g0, b1) - CUBE(r0, g0, b1)) * fr;
+  f32 c11 = CUBE(r0, g1, b1) + (CUBE(r1, g1, b1) - CUBE(r0, g1, b1)) * fr;
+#undef CUBE
+
+  f32 c0 = c00 + (c10 - c00) * fg;
+  f32 c1 = c01 + (c11 - c01) * fg;
+  return c0 + (c1 - c0) * fb;
+}
+
+static u32 post_toChannel(f32 value)
+{
+  if (value < 0.0f)
+    value = 0.0f;
+  if (value > 1.0f)
+    value = 1.0f;
+  return (u32)(value * 255.0f + 0.5f);
+}
+
+/* Reads an Adobe/Resolve style .cube (LUT_3D_SIZE n, red fastest, values in
+ * 0..1) and bakes it into the POST_LUT_ENTRIES table used at runtime, so the
+ * per pixel cost is a single fetch whatever the file's resolution. */
+int post_loadLUT(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    fprintf(stderr, "\033[31m[ERROR] Failed to open LUT '%s'\033[0m\n", path);
+    return -1;
+  }
+
+  int size = 0;
+  int count = 0;
+  f32 *cube = NULL;
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+  {
+    char *p = line;
+    while (*p && isspace((unsigned char)*p))
+      p++;
+    if (*p == '\0' || *p == '#')
+      continue;
+
+    if (strncmp(p, "LUT_3D_SIZE", 11) == 0)
+    {
+      size = atoi(p + 11);
+      if (size < 2 || size > POST_LUT_MAX_SIZE || cube)
+        break;
+      cube = malloc((size_t)size * size * size * 3 * sizeof(f32));
+      if (!cube)
+        break;
+      continue;
+    }
+    if (!isdigit((unsigned char)*p) && *p != '-' && *p != '.')
+      continue; // TITLE, DOMAIN_MIN/MAX, ...
+    if (!cube || count >= size * size * size)
+      break;
+
+    f32 r, g, b;
+    if (sscanf(p, "%f %f %f", &r, &g, &b) != 3)
+      break;
+    cube[count * 3 + 0] = r;
+    cube[count * 3 + 1] = g;
+    cube[count * 3 + 2] = b;
+    count++;
+  }
+  fclose(file);
+
+  if (!cube || count != size * size * size)
+  {
+    fprintf(stderr, "\033[31m[ERROR] Invalid LUT '%s' (%d entries)\033[0m\n",
+            path, count);
+    free(cube);
+    return -1;
+  }
+
+  pixel_t *lut = malloc((size_t)POST_LUT_ENTRIES * sizeof(pixel_t));
+  if (!lut)
+  {
+    free(cube);
+    return -1;
+  }
+
+  for (u32 i = 0; i < POST_LUT_ENTRIES; ++i)
+  {
+#ifdef PIXEL_RGB565
+    u32 in = pixel_toARGB((pixel_t)i);
+    f32 fr = (f32)((in >> 16) & 0xFF) / 255.0f;
+    f32 fg = (f32)((in >> 8) & 0xFF) / 255.0f;
+    f32 fb = (f32)(in & 0xFF) / 255.0f;
+#else
+    // sample every grid cell at the centre of the colours that map to it
+    const f32 cellScale = (f32)(1 << (8 - POST_LUT_BITS));
+    const f32 cellCenter = (cellScale - 1.0f) * 0.5f;
+    u32 r = i & (POST_LUT_GRID - 1);
+    u32 g = (i >> POST_LUT_BITS) & (POST_LUT_GRID - 1);
+    u32 b = i >> (2 * POST_LUT_BITS);
+    f32 fr = ((f32)r * cellScale + cellCenter) / 255.0f;
+    f32 fg = ((f32)g * cellScale + cellCenter) / 255.0f;
+    f32 fb = ((f32)b * cellScale + cellCenter) / 255.0f;
+#endif
+    u32 outR = post_toChannel(post_sampleCube(cube, size, fr, fg, fb, 0));
+    u32 outG = post_toChannel(post_sampleCube(cube, size, fr, fg, fb, 1));
+    u32 outB = post_toChannel(post_sampleCube(cube, size, fr, fg, fb, 2));
+    lut[i] = pixel_fromARGB(0xFF000000u | (outR << 16) | (outG << 8) | outB);
+  }
+  free(cube);
+
+  free(g_post.lut);
+  g_post.lut = lut;
+  printf("\033[32m[POST] Loaded %d^3 colour LUT: %s\033[0m\n", size, path);
+  return 0;
+}
+
+void post_resetLevelSettings(void)
+{
+  free(g_post.lut);
+  g_post.lut = NULL;
+}
+
+void post_setEnabled(int enabled)
+{
+  g_post.enabled = enabled ? 1 : 0;
+}
+
+int post_isEnabled(void)
+{
+  return g_post.enabled;
+}
+
+int post_readsFrame(void)
+{
+  return g_post.enabled && g_post.lut;
+}
+
+void post_cleanup(void)
+{
+  free(g_post.lut);
+  g_post.lut = NULL;
+}
@@ -0,0 +1,332 @@
+#include "pvs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+u64 g_pvs[PVS_TILES][PVS_WORDS];
+
+/* A sightline from inside a tile always leaves it through its boundary, so
+ * rays are fanned out from points along the edges of every open tile, each
+ * edge over the directions pointing out of it. g_rayCount[A][B] counts the
+ * rays from A that entered B; a door toggle takes back and re-casts exactly
+ * the rays that reach the door, so the counts always equal a full build.
+ * The raw set is then grown by a ring of one tile around every tile a ray
+ * reached, which covers what slips between neighbouring rays, and made
+ * symmetric. */
+#define PVS_EDGE_SAMPLES 8
+#define PVS_DIRECTIONS 1024
+#define PVS_EDGE_INSET 1e-2f // samples sit this far inside their tile
+#define PVS_TILE_GROW 1e-3f  // slack on the door square for the DDA
+
+static u16 g_rayCount[PVS_TILES][PVS_TILES];
+static u64 g_grown[PVS_TILES][PVS_WORDS];
+static f32 g_dirX[PVS_DIRECTIONS];
+static f32 g_dirY[PVS_DIRECTIONS];
+static int g_dirsReady = 0;
+
+// one tile forced to a solidity, for casting the map as it was
+typedef struct
+{
+  int index;
+  int solid;
+} PvsOverride;
+
+static inline int pvs_isSolid(int x, int y, const PvsOverride *override)
+{
+  if (x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT)
+    return 1;
+  if (override && pvs_index(x, y) == override->index)
+    return override->solid;
+  return map_isSolid(x, y);
+}
+
+static inline void pvs_setBit(u64 (*bits)[PVS_WORDS], int from, int to)
+{
+  bits[from][to >> 6] |= (u64)1 << (to & 63);
+}
+
+static inline int pvs_getBit(u64 (*bits)[PVS_WORDS], int from, int to)
+{
+  return (int)((bits[from][to >> 6] >> (to & 63)) & 1u);
+}
+
+static void pvs_initDirections(void)
+{
+  if (g_dirsReady)
+    return;
+  const f64 step = 2.0 * 3.14159265358979323846 / PVS_DIRECTIONS;
+  for (int k = 0; k < PVS_DIRECTIONS; ++k)
+  {
+    g_dirX[k] = (f32)cos(step * k);
+    g_dirY[k] = (f32)sin(step * k);
+  }
+  g_dirsReady = 1;
+}
+
+static void pvs_castRay(int from, f32 originX, f32 originY, int dir,
+                        const PvsOverride *override, int delta)
+{
+  const f32 dirX = g_dirX[dir];
+  const f32 dirY = g_dirY[dir];
+  int mapX = (int)originX;
+  int mapY = (int)originY;
+  f32 deltaDistX = (dirX == 0.0f) ? 1e30f : fabsf(1.0f / dirX);
+  f32 deltaDistY = (dirY == 0.0f) ? 1e30f : fabsf(1.0f / dirY);
+  int stepX = (dirX < 0.0f) ? -1 : 1;
+  int stepY = (dirY < 0.0f) ? -1 : 1;
+  f32 sideDistX = (dirX < 0.0f) ? (originX - mapX) * deltaDistX
+                                : (mapX + 1.0f - originX) * deltaDistX;
+  f32 sideDistY = (dirY < 0.0f) ? (originY - mapY) * deltaDistY
+                                : (mapY + 1.0f - originY) * deltaDistY;
+
+  for (;;)
+  {
+    if (sideDistX < sideDistY)
+    {
+      sideDistX += deltaDistX;
+      mapX += stepX;
+    }
+    else
+    {
+      sideDistY += deltaDistY;
+      mapY += stepY;
+    }
+    if (pvs_isSolid(mapX, mapY, override))
+      return;
+    u16 *count = &g_rayCount[from][pvs_index(mapX, mapY)];
+    *count = (u16)(*count + delta);
+  }
+}
+
+/* Index range [first, last] of the directions from (px, py) that hit the
+ * grown square of the tile, last may pass PVS_DIRECTIONS and wraps. */
+static void pvs_directionsToward(f32 px, f32 py, int tileX, int tileY,
+                                 int *outFirst, int *outLast)
+{
+  const f64 turn = 2.0 * 3.14159265358979323846;
+  f64 centre = atan2((f64)tileY + 0.5 - py, (f64)tileX + 0.5 - px);
+  f64 lo = 0.0;
+  f64 hi = 0.0;
+  for (int c = 0; c < 4; ++c)
+  {
+    f64 cx = (f64)tileX + ((c & 1) ? 1.0 + PVS_TILE_GROW : -PVS_TILE_GROW);
+    f64 cy = (f64)tileY + ((c & 2) ? 1.0 + PVS_TILE_GROW : -PVS_TILE_GROW);
+    f64 diff = atan2(cy - py, cx - px) - centre;
+    diff -= turn * floor((diff + turn * 0.5) / turn);
+    lo = diff < lo ? diff : lo;
+    hi = diff > hi ? diff : hi;
+  }
+  int first = (int)ceil((centre + lo) * PVS_DIRECTIONS / turn);
+  int last = (int)floor((centre + hi) * PVS_DIRECTIONS / turn);
+  int wrap = (first < 0) ? (-first / PVS_DIRECTIONS + 1) * PVS_DIRECTIONS : 0;
+  *outFirst = first + wrap;
+  *outLast = last + wrap;
+}
+
+/* Casts the rays of tile A, adding delta to its counts. With towardTile
+ * set, only the rays that can reach that tile are cast. */
+static void pvs_castTile(int ax, int ay, int towardTile,
+                         const PvsOverride *override, int delta)
+{
+  static const struct
+  {
+    f32 x0, y0, x1, y1; // edge, inset into the tile
+    int normalX, normalY;
+  } edges[4] = {
+      {PVS_EDGE_INSET, PVS_EDGE_INSET, PVS_EDGE_INSET, 1.0f - PVS_EDGE_INSET,
+       -1, 0},
+      {1.0f - PVS_EDGE_INSET, PVS_EDGE_INSET, 1.0f - PVS_EDGE_INSET,
+       1.0f - PVS_EDGE_INSET, 1, 0},
+      {PVS_EDGE_INSET, PVS_EDGE_INSET, 1.0f - PVS_EDGE_INSET, PVS_EDGE_INSET,
+       0, -1},
+      {PVS_EDGE_INSET, 1.0f - PVS_EDGE_INSET, 1.0f - PVS_EDGE_INSET,
+       1.0f - PVS_EDGE_INSET, 0, 1},
+  };
+
+  const int a = pvs_index(ax, ay);
+  for (int e = 0; e < 4; ++e)
+  {
+    // nothing leaves through an edge onto a wall
+    if (pvs_isSolid(ax + edges[e].normalX, ay + edges[e].normalY, override))
+      continue;
+
+    for (int s = 0; s < PVS_EDGE_SAMPLES; ++s)
+    {
+      f32 t = (f32)s / (f32)(PVS_EDGE_SAMPLES - 1);
+      f32 px = (f32)ax + edges[e].x0 + (edges[e].x1 - edges[e].x0) * t;
+      f32 py = (f32)ay + edges[e].y0 + (edges[e].y1 - edges[e].y0) * t;
+
+      int first = 0;
+      int last = PVS_DIRECTIONS - 1;
+      if (towardTile >= 0)
+        pvs_directionsToward(px, py, towardTile / MAP_HEIGHT,
+                             towardTile % MAP_HEIGHT, &first, &last);
+      for (int k = first; k <= last; ++k)
+      {
+        int dir = k % PVS_DIRECTIONS;
+        if (g_dirX[dir] * edges[e].normalX + g_dirY[dir] * edges[e].normalY <=
+            0.0f)
+          continue;
+        pvs_castRay(a, px, py, dir, override, delta);
+      }
+    }
+  }
+}
+
+// the rays of A plus the open tiles around everything they reached
+static void pvs_growRow(int a)
+{
+  memset(g_grown[a], 0, sizeof(g_grown[a]));
+  int ax = a / MAP_HEIGHT;
+  int ay = a % MAP_HEIGHT;
+  if (pvs_isSolid(ax, ay, NULL))
+    return;
+
+  for (int b = 0; b < PVS_TILES; ++b)
+  {
+    if (b != a && g_rayCount[a][b] == 0)
+      continue;
+    int bx = b / MAP_HEIGHT;
+    int by = b % MAP_HEIGHT;
+    for (int nx = bx - 1; nx <= bx + 1; ++nx)
+      for (int ny = by - 1; ny <= by + 1; ++ny)
+        if (!pvs_isSolid(nx, ny, NULL))
+          pvs_setBit(g_grown, a, pvs_index(nx, ny));
+  }
+}
+
+// row and column of A in the symmetric table
+static void pvs_mirrorRow(int a)
+{
+  for (int b = 0; b < PVS_TILES; ++b)
+  {
+    u64 bitB = (u64)1 << (b & 63);
+    u64 bitA = (u64)1 << (a & 63);
+    if (pvs_getBit(g_grown, a, b) || pvs_getBit(g_grown, b, a))
+    {
+      g_pvs[a][b >> 6] |= bitB;
+      g_pvs[b][a >> 6] |= bitA;
+    }
+    else
+    {
+      g_pvs[a][b >> 6] &= ~bitB;
+      g_pvs[b][a >> 6] &= ~bitA;
+    }
+  }
+}
+
+void pvs_build(void)
+{
+  pvs_initDirections();
+  memset(g_rayCount, 0, sizeof(g_rayCount));
+
+  int openTiles = 0;
+  for (int ax = 0; ax < MAP_WIDTH; ++ax)
+  {
+    for (int ay = 0; ay < MAP_HEIGHT; ++ay)
+    {
+      if (pvs_isSolid(ax, ay, NULL))
+        continue;
+      pvs_castTile(ax, ay, -1, NULL, 1);
+      ++openTiles;
+    }
+  }
+
+  for (int a = 0; a < PVS_TILES; ++a)
+    pvs_growRow(a);
+  for (int a = 0; a < PVS_TILES; ++a)
+    for (int w = 0; w < PVS_WORDS; ++w)
+      g_pvs[a][w] = 0;
+  for (int a = 0; a < PVS_TILES; ++a)
+    for (int b = 0; b < PVS_TILES; ++b)
+      if (pvs_getBit(g_grown, a, b))
+      {
+        pvs_setBit(g_pvs, a, b);
+        pvs_setBit(g_pvs, b, a);
+      }
+
+  printf("\033[32m[PVS] Built for %d open tiles (%zu bytes)\033[0m\n",
+         openTiles, sizeof(g_pvs) + sizeof(g_grown) + sizeof(g_rayCount));
+}
+
+void pvs_onTileChanged(int tileX, int tileY)
+{
+  if (tileX < 0 || tileX >= MAP_WIDTH || tileY < 0 || tileY >= MAP_HEIGHT)
+    return;
+
+  // open tiles always see themselves, so the old state is still in the table
+  const int changed = pvs_index(tileX, tileY);
+  const int wasSolid = !pvs_testBit(changed, changed);
+  const int isSolid = map_isSolid(tileX, tileY);
+  if (wasSolid == isSolid)
+    return;
+  pvs_initDirections();
+
+  /* Rays that reach the tile either enter it or stop on its face, coming
+   * from one of its neighbours, so only rows that reached the 3x3 block can
+   * change; the ring growth around the tile stays inside them as well. */
+  static int rows[PVS_TILES];
+  int rowCount = 0;
+  for (int a = 0; a < PVS_TILES; ++a)
+  {
+    int ax = a / MAP_HEIGHT;
+    int ay = a % MAP_HEIGHT;
+    if (a == changed || pvs_isSolid(ax, ay, NULL))
+      continue;
+    int reaches = abs(ax - tileX) <= 1 && abs(ay - tileY) <= 1;
+    for (int nx = tileX - 1; !reaches && nx <= tileX + 1; ++nx)
+      for (int ny = tileY - 1; !reaches && ny <= tileY + 1; ++ny)
+        reaches = nx >= 0 && nx < MAP_WIDTH && ny >= 0 && ny < MAP_HEIGHT &&
+                  g_rayCount[a][pvs_index(nx, ny)] > 0;
+    if (reaches)
+      rows[rowCount++] = a;
+  }
+
+  const PvsOverride before = {changed, wasSolid};
+  for (int r = 0; r < rowCount; ++r)
+  {
+    int ax = rows[r] / MAP_HEIGHT;
+    int ay = rows[r] % MAP_HEIGHT;
+    pvs_castTile(ax, ay, changed, &before, -1);
+    pvs_castTile(ax, ay, changed, NULL, 1);
+  }
+  memset(g_rayCount[changed], 0, sizeof(g_rayCount[changed]));
+  if (!isSolid)
+    pvs_castTile(tileX, tileY, -1, NULL, 1);
+
+  rows[rowCount++] = changed;
+  for (int r = 0; r < rowCount; ++r)
+    pvs_growRow(rows[r]);
+  for (int r = 0; r < rowCount; ++r)
+    pvs_mirrorRow(rows[r]);
+}
+
+int pvs_canSee(int fromX, int fromY, int toX, int toY)
+{
+  if (fromX < 0 || fromX >= MAP_WIDTH || fromY < 0 || fromY >= MAP_HEIGHT ||
+      toX < 0 || toX >= MAP_WIDTH || toY < 0 || toY >= MAP_HEIGHT)
+    return 1;
+
+  // a viewer inside a solid tile has no row, stay conservative
+  if (map_isSolid(fromX, fromY))
+    return 1;
+
+  int from = pvs_index(fromX, fromY);
+  if (!map_isSolid(toX, toY))
+    return pvs_testBit(from, pvs_index(toX, toY));
+
+  // a solid tile is seen through the faces of its open neighbours
+  static const int neighbours[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+  for (int i = 0; i < 4; ++i)
+  {
+    int nx = toX + neighbours[i][0];
+    int ny = toY + neighbours[i][1];
+    if (nx < 0 || nx >= MAP_WIDTH || ny < 0 || ny >= MAP_HEIGHT ||
+        map_isSolid(nx, ny))
+      continue;
+    if (pvs_testBit(from, pvs_index(nx, ny)))
+      return 1;
+  }
+  return 0;
+}
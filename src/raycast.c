@@ -1,13 +1,29 @@
 #include "raycast.h"
 #include "engine.h"
 #include "map.h"
+#include "automap.h"
+#include "blit.h"
+#include "distfield.h"
+#include "dynlight.h"
 #include "entities.h"
+#include "fog.h"
+#include "lightmap.h"
+#include "texcache.h"
+#include <limits.h>
 
 int g_floorTextureId = 3;
 int g_ceilingTextureId = 6;
 
 void perform_raycasting(Engine *engine)
 {
+  distfield_update();
+
+  int playerTileX = (int)engine->player.posX;
+  int playerTileY = (int)engine->player.posY;
+  if (playerTileX >= 0 && playerTileX < MAP_WIDTH && playerTileY >= 0 &&
+      playerTileY < MAP_HEIGHT)
+    automap_markSeen(playerTileX, playerTileY);
+
   for (int x = 0; x < RENDER_WIDTH; x++)
   {
     // map x coordinates
@@ -38,29 +54,95 @@ void perform_raycasting(Engine *engine)
 
     int hit = 0;
     int side;
+    int steps = 0;
 
     while (!hit)
     {
+      // distance to the grid line about to be crossed, bounded by the far
+      // plane so open or huge maps cannot march forever
+      f64 crossing;
+      int skip = (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 &&
+                  mapY < MAP_HEIGHT)
+                     ? g_distField[mapX][mapY] - 1
+                     : 0;
+      if (skip > 0)
+      {
+        /* Every tile within `skip` steps is open and seen, so take all the
+         * crossings before the ray first leaves that square in one go. */
+        f64 exitX = sideDistX + skip * deltaDistX;
+        f64 exitY = sideDistY + skip * deltaDistY;
+        f64 exit = (exitX < exitY) ? exitX : exitY;
+        int countX = (sideDistX < exit)
+                         ? (int)ceil((exit - sideDistX) / deltaDistX)
+                         : 0;
+        int countY = (sideDistY < exit)
+                         ? (int)ceil((exit - sideDistY) / deltaDistY)
+                         : 0;
+        if (countX > skip)
+          countX = skip;
+        if (countY > skip)
+          countY = skip;
+        if (countX + countY > 1)
+        {
+          f64 lastX = sideDistX + (countX - 1) * deltaDistX;
+          f64 lastY = sideDistY + (countY - 1) * deltaDistY;
+          // on a tie the DDA takes the y crossing first
+          side = (countX > 0 && (countY == 0 || lastX >= lastY)) ? 0 : 1;
+          crossing = (side == 0) ? lastX : lastY;
+          sideDistX += countX * deltaDistX;
+          sideDistY += countY * deltaDistY;
+          mapX += countX * stepX;
+          mapY += countY * stepY;
+          steps += countX + countY;
+          if (crossing > g_fog.farDistance || steps > g_fog.maxSteps)
+            break;
+          continue;
+        }
+      }
+
       if (sideDistX < sideDistY)
       {
+        crossing = sideDistX;
         sideDistX += deltaDistX; // move to next horizontal grid line
         mapX += stepX;
         side = 0; // vertical wall hit (NS)
       }
       else
       {
+        crossing = sideDistY;
         sideDistY += deltaDistY; // move to next vertical grid line
         mapY += stepY;
         side = 1; // horizontal wall hit (EW)
       }
 
-      if (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 && mapY < MAP_HEIGHT &&
-          worldMap[mapX][mapY] > 0)
+      if (crossing > g_fog.farDistance || ++steps > g_fog.maxSteps)
+        break;
+
+      if (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 && mapY < MAP_HEIGHT)
       {
-        hit = 1;
+        automap_markSeen(mapX, mapY);
+        if (map_isSolid(mapX, mapY))
+          hit = 1;
       }
     }
 
+    if (!hit)
+    {
+      // nothing inside the far plane, the wall slot is solid fog
+      int fogHeight = (int)(RENDER_HEIGHT / g_fog.farDistance);
+      int fogStart =
+          -fogHeight / 2 + RENDER_HEIGHT / 2 + (int)engine->player.pitch;
+      int fogEnd = fogHeight / 2 + RENDER_HEIGHT / 2 + (int)engine->player.pitch;
+      if (fogStart < 0)
+        fogStart = 0;
+      if (fogEnd >= RENDER_HEIGHT)
+        fogEnd = RENDER_HEIGHT - 1;
+      for (int y = fogStart; y < fogEnd; y++)
+        engine->game.Rbuffer[y * RENDER_WIDTH + x] = g_fog.pixel;
+      engine->game.Zbuffer[x] = g_fog.farDistance;
+      continue;
+    }
+
     // calculate perpendicular walldist (no fisheye effect)
     double perpWallDist =
         (side == 0) ? sideDistX - deltaDistX : sideDistY - deltaDistY;
@@ -80,6 +162,7 @@ void perform_raycasting(Engine *engine)
     // texturing
     // get texture index in map array (-1 so we can use texture 0 as air)
     int texNum = worldMap[mapX][mapY] - 1;
+    TextureView wallTex = texcache_view(texNum);
 
     // calculate value of wallX
     double wallX;
@@ -91,15 +174,15 @@ void perform_raycasting(Engine *engine)
 
     // x coordinate on the texture
     // flip texture depending on direction to not appear mirrored
-    int texX = (int)(wallX * (double)TEXT_WIDTH);
+    int texX = (int)(wallX * (double)wallTex.width);
     if (side == 0 && rayDirX > 0)
-      texX = TEXT_WIDTH - texX - 1;
+      texX = wallTex.width - texX - 1;
     if (side == 1 && rayDirY < 0)
-      texX = TEXT_WIDTH - texX - 1;
+      texX = wallTex.width - texX - 1;
 
     // Vertical texture Sampling
     // How much to increase the texture coordinate per screen pixel
-    double step = 1.0 * TEXT_HEIGHT / lineHeight;
+    double step = 1.0 * wallTex.height / lineHeight;
 
     // Starting texture coordinate
     double texPos = (drawStart - (int)engine->player.pitch - RENDER_HEIGHT / 2 +
@@ -113,74 +196,100 @@ void perform_raycasting(Engine *engine)
     else
       faceY = -stepY;
 
+    // baked light for this column of the face plus the dynamic light of the
+    // tile in front of it, one level per LIGHT_FACE_RES rows
+    const u8 *faceLight = lightmap_wallFace(mapX, mapY, faceX, faceY) +
+                          (int)(wallX * LIGHT_FACE_RES);
+    u32 dynLight = dynlight_level(mapX + faceX, mapY + faceY);
+    u32 fogWeight = fog_weight((f32)perpWallDist);
+    u8 columnLight[LIGHT_FACE_RES];
+    for (int row = 0; row < LIGHT_FACE_RES; row++)
+    {
+      columnLight[row] = (u8)lightmap_addLevel(faceLight[row * LIGHT_FACE_RES],
+                                               dynLight);
+    }
+
+    // lever and wall text on this face are fixed for the whole column
+    const pixel_t *leverTex = NULL;
+    int leverTexIndex =
+        entities_getLeverTextureAtFace(mapX, mapY, faceX, faceY, NULL);
+    if (leverTexIndex >= 0)
+      leverTex = engine->textures.textures[leverTexIndex];
+
+    const u32 *wallTextPixels = NULL;
+    float wallTextScale = 1.0f;
+    float wallTextCovX = 1.0f;
+    float wallTextCovY = 1.0f;
+    if (!entities_getWallTextAt(mapX, mapY, faceX, faceY, &wallTextPixels,
+                                &wallTextScale, &wallTextCovX, &wallTextCovY))
+      wallTextPixels = NULL;
+    if (wallTextPixels)
+    {
+      float coverageX = wallTextCovX * wallTextScale;
+      float coverageY = wallTextCovY * wallTextScale;
+      if (coverageX <= 0.0f)
+        coverageX = wallTextCovX;
+      if (coverageY <= 0.0f)
+        coverageY = wallTextCovY;
+      if (coverageX <= 0.0f)
+        coverageX = 1.0f;
+      if (coverageY <= 0.0f)
+        coverageY = 1.0f;
+      if (coverageX > 1.0f)
+        coverageX = 1.0f;
+      if (coverageY > 1.0f)
+        coverageY = 1.0f;
+      wallTextCovX = coverageX;
+      wallTextCovY = coverageY;
+    }
+
+    // the column is shaded into a local strip first so the wall text blend
+    // and the fog store run as whole-strip kernels
+    pixel_t column[RENDER_HEIGHT];
+    u32 columnText[RENDER_HEIGHT];
+
     // Draw the textured vertical line
     for (int y = drawStart; y < drawEnd; y++)
     {
-      int texY = (int)texPos & (TEXT_HEIGHT - 1);
+      int texY = (int)texPos & wallTex.maskY;
       texPos += step;
 
-      u32 color = engine->textures.textures[texNum][texY * TEXT_WIDTH + texX];
+      pixel_t color = wallTex.pixels[(texY << wallTex.shiftX) + texX];
 
-      if (side == 1)
-        color = (color >> 1) & 8355711;
+      color = lightmap_shade(
+          color, columnLight[(texY * LIGHT_FACE_RES) >> wallTex.shiftY]);
 
-      int leverTexIndex =
-          entities_getLeverTextureAtFace(mapX, mapY, faceX, faceY, NULL);
-      if (leverTexIndex >= 0)
+      if (leverTex)
       {
-        const u32 *leverTex = engine->textures.textures[leverTexIndex];
-        if (leverTex)
+        const float coverageX = 0.3f;
+        const float coverageY = 0.35f;
+        float u = ((float)texX + 0.5f) / (float)wallTex.width;
+        float v = ((float)texY + 0.5f) / (float)wallTex.height;
+        float localU = (u - 0.5f) / coverageX + 0.5f;
+        float localV = (v - 0.5f) / coverageY + 0.5f;
+        if (localU >= 0.0f && localU <= 1.0f && localV >= 0.0f &&
+            localV <= 1.0f)
         {
-          const float coverageX = 0.3f;
-          const float coverageY = 0.35f;
-          float u = ((float)texX + 0.5f) / (float)TEXT_WIDTH;
-          float v = ((float)texY + 0.5f) / (float)TEXT_HEIGHT;
-          float localU = (u - 0.5f) / coverageX + 0.5f;
-          float localV = (v - 0.5f) / coverageY + 0.5f;
-          if (localU >= 0.0f && localU <= 1.0f && localV >= 0.0f &&
-              localV <= 1.0f)
+          int sampleX = (int)(localU * (float)(TEXT_WIDTH - 1));
+          int sampleY = (int)(localV * (float)(TEXT_HEIGHT - 1));
+          if (sampleX >= 0 && sampleX < TEXT_WIDTH && sampleY >= 0 &&
+              sampleY < TEXT_HEIGHT)
           {
-            int sampleX = (int)(localU * (float)(TEXT_WIDTH - 1));
-            int sampleY = (int)(localV * (float)(TEXT_HEIGHT - 1));
-            if (sampleX >= 0 && sampleX < TEXT_WIDTH && sampleY >= 0 &&
-                sampleY < TEXT_HEIGHT)
-            {
-              u32 leverColor = leverTex[sampleY * TEXT_WIDTH + sampleX];
-              if ((leverColor & 0xFF000000u) != 0)
-                color = leverColor;
-            }
+            pixel_t leverColor = leverTex[sampleY * TEXT_WIDTH + sampleX];
+            if (pixel_isOpaque(leverColor))
+              color = leverColor;
           }
         }
       }
 
-      const u32 *wallTextPixels = NULL;
-      float wallTextScale = 1.0f;
-      float wallTextBaseCovX = 1.0f;
-      float wallTextBaseCovY = 1.0f;
-      if (entities_getWallTextAt(mapX, mapY, faceX, faceY, &wallTextPixels,
-                                 &wallTextScale, &wallTextBaseCovX,
-                                 &wallTextBaseCovY) &&
-          wallTextPixels)
+      // wall text keeps its alpha and is blended below in ARGB8888
+      u32 textColor = 0;
+      if (wallTextPixels)
       {
-        float coverageX = wallTextBaseCovX * wallTextScale;
-        float coverageY = wallTextBaseCovY * wallTextScale;
-        if (coverageX <= 0.0f)
-          coverageX = wallTextBaseCovX;
-        if (coverageY <= 0.0f)
-          coverageY = wallTextBaseCovY;
-        if (coverageX <= 0.0f)
-          coverageX = 1.0f;
-        if (coverageY <= 0.0f)
-          coverageY = 1.0f;
-        if (coverageX > 1.0f)
-          coverageX = 1.0f;
-        if (coverageY > 1.0f)
-          coverageY = 1.0f;
-
-        float u = ((float)texX + 0.5f) / (float)TEXT_WIDTH;
-        float v = ((float)texY + 0.5f) / (float)TEXT_HEIGHT;
-        float localU = (u - 0.5f) / coverageX + 0.5f;
-        float localV = (v - 0.5f) / coverageY + 0.5f;
+        float u = ((float)texX + 0.5f) / (float)wallTex.width;
+        float v = ((float)texY + 0.5f) / (float)wallTex.height;
+        float localU = (u - 0.5f) / wallTextCovX + 0.5f;
+        float localV = (v - 0.5f) / wallTextCovY + 0.5f;
         if (localU >= 0.0f && localU <= 1.0f && localV >= 0.0f &&
             localV <= 1.0f)
         {
@@ -188,41 +297,20 @@ void perform_raycasting(Engine *engine)
           int sampleY = (int)(localV * (float)(TEXT_HEIGHT - 1));
           if (sampleX >= 0 && sampleX < TEXT_WIDTH && sampleY >= 0 &&
               sampleY < TEXT_HEIGHT)
-          {
-            u32 textColor = wallTextPixels[sampleY * TEXT_WIDTH + sampleX];
-            Uint8 alpha = (Uint8)((textColor >> 24) & 0xFFu);
-            if (alpha != 0)
-            {
-              Uint8 srcR = (Uint8)((textColor >> 16) & 0xFFu);
-              Uint8 srcG = (Uint8)((textColor >> 8) & 0xFFu);
-              Uint8 srcB = (Uint8)(textColor & 0xFFu);
-
-              Uint8 dstR = (Uint8)((color >> 16) & 0xFFu);
-              Uint8 dstG = (Uint8)((color >> 8) & 0xFFu);
-              Uint8 dstB = (Uint8)(color & 0xFFu);
-
-              Uint32 invAlpha = 255u - (Uint32)alpha;
-              Uint8 outR =
-                  (Uint8)(((Uint32)srcR * (Uint32)alpha +
-                           (Uint32)dstR * invAlpha + 127u) /
-                          255u);
-              Uint8 outG =
-                  (Uint8)(((Uint32)srcG * (Uint32)alpha +
-                           (Uint32)dstG * invAlpha + 127u) /
-                          255u);
-              Uint8 outB =
-                  (Uint8)(((Uint32)srcB * (Uint32)alpha +
-                           (Uint32)dstB * invAlpha + 127u) /
-                          255u);
-
-              color = (0xFFu << 24) | ((Uint32)outR << 16) |
-                      ((Uint32)outG << 8) | (Uint32)outB;
-            }
-          }
+            textColor = wallTextPixels[sampleY * TEXT_WIDTH + sampleX];
         }
       }
 
-      engine->game.Rbuffer[y * RENDER_WIDTH + x] = color;
+      column[y - drawStart] = color;
+      columnText[y - drawStart] = textColor;
+    }
+
+    if (wallTextPixels)
+      g_blit.blendAlpha(column, columnText, drawEnd - drawStart);
+    for (int y = drawStart; y < drawEnd; y++)
+    {
+      engine->game.Rbuffer[y * RENDER_WIDTH + x] =
+          fog_blend(column[y - drawStart], fogWeight);
     }
     // set z-buffer for sprites
     engine->game.Zbuffer[x] = perpWallDist;
@@ -231,6 +319,9 @@ void perform_raycasting(Engine *engine)
 
 void perform_floorcasting(Engine *engine)
 {
+  TextureView floorTex = texcache_view(g_floorTextureId);
+  TextureView ceilingTex = texcache_view(g_ceilingTextureId);
+
   // FLOOR CASTING
   for (int y = 0; y < RENDER_HEIGHT; y++)
   {
@@ -255,42 +346,60 @@ void perform_floorcasting(Engine *engine)
     f32 floorStepX = rowDistance * (rayDirX1 - rayDirX0) / RENDER_WIDTH;
     f32 floorStepY = rowDistance * (rayDirY1 - rayDirY0) / RENDER_WIDTH;
 
+    // rows beyond the far plane are pure fog
+    u32 fogWeight = fog_weight(rowDistance);
+    if (fogWeight >= 256)
+    {
+      g_blit.clear(engine->game.Rbuffer + y * RENDER_WIDTH, g_fog.pixel,
+                   RENDER_WIDTH);
+      continue;
+    }
+
+    // below the horizon is floor, above it ceiling
+    const TextureView *tex = (p > 0) ? &floorTex : &ceilingTex;
+
     // Real world coordinates of the leftmost column
     f32 floorX = engine->player.posX + rowDistance * rayDirX0;
     f32 floorY = engine->player.posY + rowDistance * rayDirY0;
 
+    // baked and dynamic light only change when the row enters a new cell
+    int runCellX = INT_MIN;
+    int runCellY = INT_MIN;
+    const u8 *cellLight = NULL;
+    u32 dynLight = 0;
+
+    pixel_t *out = engine->game.Rbuffer + y * RENDER_WIDTH;
     for (int x = 0; x < RENDER_WIDTH; ++x)
     {
       // Get cell coordinates
       int cellX = (int)(floorX);
       int cellY = (int)(floorY);
+      if (cellX != runCellX || cellY != runCellY)
+      {
+        // Floor below the horizon, ceiling above it
+        cellLight = (p > 0) ? lightmap_floorTile(cellX, cellY)
+                            : lightmap_ceilingTile(cellX, cellY);
+        dynLight = dynlight_level(cellX, cellY);
+        runCellX = cellX;
+        runCellY = cellY;
+      }
 
       // Get texture coordinate from the fractional part
-      int tx = (int)(TEXT_WIDTH * (floorX - cellX)) & (TEXT_WIDTH - 1);
-      int ty = (int)(TEXT_HEIGHT * (floorY - cellY)) & (TEXT_HEIGHT - 1);
+      int tx = (int)(tex->width * (floorX - cellX)) & tex->maskX;
+      int ty = (int)(tex->height * (floorY - cellY)) & tex->maskY;
+
+      // baked light cell matching this texel
+      int lightIndex = ((ty * LIGHT_FACE_RES) >> tex->shiftY) * LIGHT_FACE_RES +
+                       ((tx * LIGHT_FACE_RES) >> tex->shiftX);
 
       floorX += floorStepX;
       floorY += floorStepY;
 
-      // Choose texture and draw the pixel
-      int floorTexture = g_floorTextureId;
-      int ceilingTexture = g_ceilingTextureId;
-      u32 color;
-
-      if (p > 0)
-      {
-        // Floor (below horizon)
-        color = engine->textures.textures[floorTexture][TEXT_WIDTH * ty + tx];
-        color = (color >> 1) & 8355711;
-        engine->game.Rbuffer[y * RENDER_WIDTH + x] = color;
-      }
-      else
-      {
-        // Ceiling (above horizon)
-        color = engine->textures.textures[ceilingTexture][TEXT_WIDTH * ty + tx];
-        color = (color >> 1) & 8355711;
-        engine->game.Rbuffer[y * RENDER_WIDTH + x] = color;
-      }
+      // draw the pixel
+      pixel_t color = tex->pixels[(ty << tex->shiftX) + tx];
+      color = lightmap_shade(
+          color, lightmap_addLevel(cellLight[lightIndex], dynLight));
+      out[x] = fog_blend(color, fogWeight);
     }
   }
 }
@@ -0,0 +1,356 @@
+#include "rayquery.h"
+#include "blit.h"
+#include "map.h"
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__))
+#define RAYQUERY_X86 1
+#include <immintrin.h>
+#define RAYQUERY_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// stands in for 1 / 0 on axis aligned rays
+#define RAYQUERY_FAR 1e30f
+
+// reference DDA, also used for the lanes left over after the packets
+static void rayquery_castScalar(f32 originX, f32 originY, f32 dirX, f32 dirY,
+                                f32 maxDistance, RayHit *out)
+{
+  i32 mapX = (i32)originX;
+  i32 mapY = (i32)originY;
+  f32 deltaX = (dirX == 0.0f) ? RAYQUERY_FAR : fabsf(1.0f / dirX);
+  f32 deltaY = (dirY == 0.0f) ? RAYQUERY_FAR : fabsf(1.0f / dirY);
+  i32 stepX = (dirX < 0.0f) ? -1 : 1;
+  i32 stepY = (dirY < 0.0f) ? -1 : 1;
+  f32 sideX = (dirX < 0.0f) ? (originX - (f32)mapX) * deltaX
+                            : ((f32)mapX + 1.0f - originX) * deltaX;
+  f32 sideY = (dirY < 0.0f) ? (originY - (f32)mapY) * deltaY
+                            : ((f32)mapY + 1.0f - originY) * deltaY;
+
+  out->hit = 0;
+  out->side = 0;
+  out->distance = 0.0f;
+  for (i32 step = 0; step < RAYQUERY_MAX_STEPS; ++step)
+  {
+    f32 crossing;
+    if (sideX < sideY)
+    {
+      crossing = sideX;
+      sideX += deltaX;
+      mapX += stepX;
+      out->side = 0;
+    }
+    else
+    {
+      crossing = sideY;
+      sideY += deltaY;
+      mapY += stepY;
+      out->side = 1;
+    }
+
+    out->distance = crossing;
+    out->tileX = mapX;
+    out->tileY = mapY;
+    if (crossing > maxDistance)
+      return;
+    if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT)
+      return;
+    if (map_isSolid(mapX, mapY))
+    {
+      out->hit = 1;
+      return;
+    }
+  }
+}
+
+#ifdef RAYQUERY_X86
+
+/* SSE2 packet: the four lanes step in lockstep, a lane that finished keeps
+ * its state frozen under the `live` mask until the whole packet is done. */
+RAYQUERY_TARGET("sse2")
+static void rayquery_cast4(const f32 *originX, const f32 *originY,
+                           const f32 *dirX, const f32 *dirY,
+                           const f32 *maxDistance, RayHit *out)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 far = _mm_set1_ps(RAYQUERY_FAR);
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128i iOne = _mm_set1_epi32(1);
+
+  __m128 ox = _mm_loadu_ps(originX);
+  __m128 oy = _mm_loadu_ps(originY);
+  __m128 dx = _mm_loadu_ps(dirX);
+  __m128 dy = _mm_loadu_ps(dirY);
+  __m128 maxDist = _mm_loadu_ps(maxDistance);
+
+  __m128i mapX = _mm_cvttps_epi32(ox);
+  __m128i mapY = _mm_cvttps_epi32(oy);
+  __m128 mapXf = _mm_cvtepi32_ps(mapX);
+  __m128 mapYf = _mm_cvtepi32_ps(mapY);
+
+  __m128 zeroX = _mm_cmpeq_ps(dx, zero);
+  __m128 zeroY = _mm_cmpeq_ps(dy, zero);
+  __m128 deltaX = _mm_or_ps(_mm_and_ps(zeroX, far),
+                            _mm_andnot_ps(zeroX, _mm_and_ps(_mm_div_ps(one, dx),
+                                                            absMask)));
+  __m128 deltaY = _mm_or_ps(_mm_and_ps(zeroY, far),
+                            _mm_andnot_ps(zeroY, _mm_and_ps(_mm_div_ps(one, dy),
+                                                            absMask)));
+
+  __m128 negX = _mm_cmplt_ps(dx, zero);
+  __m128 negY = _mm_cmplt_ps(dy, zero);
+  // step = -1 where negative, +1 elsewhere
+  __m128i stepX = _mm_or_si128(_mm_castps_si128(negX), iOne);
+  __m128i stepY = _mm_or_si128(_mm_castps_si128(negY), iOne);
+  __m128 sideX = _mm_mul_ps(
+      _mm_or_ps(_mm_and_ps(negX, _mm_sub_ps(ox, mapXf)),
+                _mm_andnot_ps(negX, _mm_sub_ps(_mm_add_ps(mapXf, one), ox))),
+      deltaX);
+  __m128 sideY = _mm_mul_ps(
+      _mm_or_ps(_mm_and_ps(negY, _mm_sub_ps(oy, mapYf)),
+                _mm_andnot_ps(negY, _mm_sub_ps(_mm_add_ps(mapYf, one), oy))),
+      deltaY);
+
+  __m128i live = _mm_set1_epi32(-1);
+  __m128i hit = _mm_setzero_si128();
+  __m128i side = _mm_setzero_si128();
+  __m128 distance = zero;
+  const __m128i mapW = _mm_set1_epi32(MAP_WIDTH);
+  const __m128i mapH = _mm_set1_epi32(MAP_HEIGHT);
+  const __m128i minusOne = _mm_set1_epi32(-1);
+
+  for (i32 step = 0; step < RAYQUERY_MAX_STEPS; ++step)
+  {
+    __m128i alongX = _mm_castps_si128(_mm_cmplt_ps(sideX, sideY));
+    __m128i moveX = _mm_and_si128(alongX, live);
+    __m128i moveY = _mm_andnot_si128(alongX, live);
+
+    __m128 crossing = _mm_or_ps(
+        _mm_and_ps(_mm_castsi128_ps(alongX), sideX),
+        _mm_andnot_ps(_mm_castsi128_ps(alongX), sideY));
+    sideX = _mm_add_ps(sideX, _mm_and_ps(_mm_castsi128_ps(moveX), deltaX));
+    sideY = _mm_add_ps(sideY, _mm_and_ps(_mm_castsi128_ps(moveY), deltaY));
+    mapX = _mm_add_epi32(mapX, _mm_and_si128(moveX, stepX));
+    mapY = _mm_add_epi32(mapY, _mm_and_si128(moveY, stepY));
+
+    __m128 liveF = _mm_castsi128_ps(live);
+    distance = _mm_or_ps(_mm_and_ps(liveF, crossing),
+                         _mm_andnot_ps(liveF, distance));
+    side = _mm_or_si128(_mm_and_si128(live, _mm_andnot_si128(alongX, iOne)),
+                        _mm_andnot_si128(live, side));
+
+    __m128i beyond = _mm_castps_si128(_mm_cmpgt_ps(crossing, maxDist));
+    __m128i inside = _mm_and_si128(
+        _mm_and_si128(_mm_cmpgt_epi32(mapX, minusOne),
+                      _mm_cmplt_epi32(mapX, mapW)),
+        _mm_and_si128(_mm_cmpgt_epi32(mapY, minusOne),
+                      _mm_cmplt_epi32(mapY, mapH)));
+    __m128i probe = _mm_andnot_si128(beyond, _mm_and_si128(inside, live));
+
+    // SSE2 has no gather, the four bitmap reads go through memory
+    i32 xs[4], ys[4], probes[4], cells[4];
+    _mm_storeu_si128((__m128i *)xs, mapX);
+    _mm_storeu_si128((__m128i *)ys, mapY);
+    _mm_storeu_si128((__m128i *)probes, probe);
+    for (int i = 0; i < 4; ++i)
+      cells[i] = (probes[i] && map_isSolid(xs[i], ys[i])) ? -1 : 0;
+    __m128i solid = _mm_loadu_si128((const __m128i *)cells);
+
+    hit = _mm_or_si128(hit, solid);
+    // a lane stops on a hit, past its max distance or outside the map
+    live = _mm_and_si128(live, _mm_andnot_si128(solid, probe));
+    if (_mm_movemask_epi8(live) == 0)
+      break;
+  }
+
+  i32 xs[4], ys[4], hits[4], sides[4];
+  f32 dists[4];
+  _mm_storeu_si128((__m128i *)xs, mapX);
+  _mm_storeu_si128((__m128i *)ys, mapY);
+  _mm_storeu_si128((__m128i *)hits, hit);
+  _mm_storeu_si128((__m128i *)sides, side);
+  _mm_storeu_ps(dists, distance);
+  for (int i = 0; i < 4; ++i)
+  {
+    out[i].distance = dists[i];
+    out[i].tileX = xs[i];
+    out[i].tileY = ys[i];
+    out[i].side = sides[i];
+    out[i].hit = hits[i] ? 1 : 0;
+  }
+}
+
+// AVX2 packet, same steps as rayquery_cast4 with a hardware map gather
+RAYQUERY_TARGET("avx2")
+static void rayquery_cast8(const f32 *originX, const f32 *originY,
+                           const f32 *dirX, const f32 *dirY,
+                           const f32 *maxDistance, RayHit *out)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 far = _mm256_set1_ps(RAYQUERY_FAR);
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+  const __m256i iOne = _mm256_set1_epi32(1);
+
+  __m256 ox = _mm256_loadu_ps(originX);
+  __m256 oy = _mm256_loadu_ps(originY);
+  __m256 dx = _mm256_loadu_ps(dirX);
+  __m256 dy = _mm256_loadu_ps(dirY);
+  __m256 maxDist = _mm256_loadu_ps(maxDistance);
+
+  __m256i mapX = _mm256_cvttps_epi32(ox);
+  __m256i mapY = _mm256_cvttps_epi32(oy);
+  __m256 mapXf = _mm256_cvtepi32_ps(mapX);
+  __m256 mapYf = _mm256_cvtepi32_ps(mapY);
+
+  __m256 zeroX = _mm256_cmp_ps(dx, zero, _CMP_EQ_OQ);
+  __m256 zeroY = _mm256_cmp_ps(dy, zero, _CMP_EQ_OQ);
+  __m256 deltaX = _mm256_blendv_ps(
+      _mm256_and_ps(_mm256_div_ps(one, dx), absMask), far, zeroX);
+  __m256 deltaY = _mm256_blendv_ps(
+      _mm256_and_ps(_mm256_div_ps(one, dy), absMask), far, zeroY);
+
+  __m256 negX = _mm256_cmp_ps(dx, zero, _CMP_LT_OQ);
+  __m256 negY = _mm256_cmp_ps(dy, zero, _CMP_LT_OQ);
+  __m256i stepX = _mm256_or_si256(_mm256_castps_si256(negX), iOne);
+  __m256i stepY = _mm256_or_si256(_mm256_castps_si256(negY), iOne);
+  __m256 sideX = _mm256_mul_ps(
+      _mm256_blendv_ps(_mm256_sub_ps(_mm256_add_ps(mapXf, one), ox),
+                       _mm256_sub_ps(ox, mapXf), negX),
+      deltaX);
+  __m256 sideY = _mm256_mul_ps(
+      _mm256_blendv_ps(_mm256_sub_ps(_mm256_add_ps(mapYf, one), oy),
+                       _mm256_sub_ps(oy, mapYf), negY),
+      deltaY);
+
+  __m256i live = _mm256_set1_epi32(-1);
+  __m256i hit = _mm256_setzero_si256();
+  __m256i side = _mm256_setzero_si256();
+  __m256 distance = zero;
+  const __m256i mapW = _mm256_set1_epi32(MAP_WIDTH);
+  const __m256i mapH = _mm256_set1_epi32(MAP_HEIGHT);
+  const __m256i wordStride = _mm256_set1_epi32(MAP_SOLID_WORDS_Y);
+  const __m256i bitMask = _mm256_set1_epi32(31);
+  const __m256i minusOne = _mm256_set1_epi32(-1);
+
+  for (i32 step = 0; step < RAYQUERY_MAX_STEPS; ++step)
+  {
+    __m256 alongXF = _mm256_cmp_ps(sideX, sideY, _CMP_LT_OQ);
+    __m256i alongX = _mm256_castps_si256(alongXF);
+    __m256i moveX = _mm256_and_si256(alongX, live);
+    __m256i moveY = _mm256_andnot_si256(alongX, live);
+
+    __m256 crossing = _mm256_blendv_ps(sideY, sideX, alongXF);
+    sideX = _mm256_add_ps(sideX,
+                          _mm256_and_ps(_mm256_castsi256_ps(moveX), deltaX));
+    sideY = _mm256_add_ps(sideY,
+                          _mm256_and_ps(_mm256_castsi256_ps(moveY), deltaY));
+    mapX = _mm256_add_epi32(mapX, _mm256_and_si256(moveX, stepX));
+    mapY = _mm256_add_epi32(mapY, _mm256_and_si256(moveY, stepY));
+
+    distance =
+        _mm256_blendv_ps(distance, crossing, _mm256_castsi256_ps(live));
+    side = _mm256_blendv_epi8(side, _mm256_andnot_si256(alongX, iOne), live);
+
+    __m256i beyond =
+        _mm256_castps_si256(_mm256_cmp_ps(crossing, maxDist, _CMP_GT_OQ));
+    __m256i inside = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(mapX, minusOne),
+                         _mm256_cmpgt_epi32(mapW, mapX)),
+        _mm256_and_si256(_mm256_cmpgt_epi32(mapY, minusOne),
+                         _mm256_cmpgt_epi32(mapH, mapY)));
+    __m256i probe =
+        _mm256_andnot_si256(beyond, _mm256_and_si256(inside, live));
+
+    // gather the column words, then shift each lane's bit down
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(mapX, wordStride),
+                                     _mm256_srli_epi32(mapY, 5));
+    __m256i words = _mm256_mask_i32gather_epi32(
+        _mm256_setzero_si256(), (const int *)&g_solidColumns[0][0], index,
+        probe, 4);
+    __m256i bits = _mm256_and_si256(
+        _mm256_srlv_epi32(words, _mm256_and_si256(mapY, bitMask)), iOne);
+    __m256i solid =
+        _mm256_and_si256(_mm256_cmpeq_epi32(bits, iOne), probe);
+
+    hit = _mm256_or_si256(hit, solid);
+    live = _mm256_and_si256(live, _mm256_andnot_si256(solid, probe));
+    if (_mm256_movemask_epi8(live) == 0)
+      break;
+  }
+
+  i32 xs[8], ys[8], hits[8], sides[8];
+  f32 dists[8];
+  _mm256_storeu_si256((__m256i *)xs, mapX);
+  _mm256_storeu_si256((__m256i *)ys, mapY);
+  _mm256_storeu_si256((__m256i *)hits, hit);
+  _mm256_storeu_si256((__m256i *)sides, side);
+  _mm256_storeu_ps(dists, distance);
+  for (int i = 0; i < 8; ++i)
+  {
+    out[i].distance = dists[i];
+    out[i].tileX = xs[i];
+    out[i].tileY = ys[i];
+    out[i].side = sides[i];
+    out[i].hit = hits[i] ? 1 : 0;
+  }
+}
+
+#endif
+
+void rayquery_cast(const f32 *originX, const f32 *originY, const f32 *dirX,
+                   const f32 *dirY, const f32 *maxDistance, RayHit *out,
+                   int count)
+{
+  int i = 0;
+#ifdef RAYQUERY_X86
+  // follows the SIMD level the blit kernels picked, RAYCASTER_SIMD included
+  if (g_blit.level >= BLIT_AVX2)
+  {
+    for (; i + 8 <= count; i += 8)
+      rayquery_cast8(originX + i, originY + i, dirX + i, dirY + i,
+                     maxDistance + i, out + i);
+  }
+  if (g_blit.level >= BLIT_SSE2)
+  {
+    for (; i + 4 <= count; i += 4)
+      rayquery_cast4(originX + i, originY + i, dirX + i, dirY + i,
+                     maxDistance + i, out + i);
+  }
+#endif
+  for (; i < count; ++i)
+    rayquery_castScalar(originX[i], originY[i], dirX[i], dirY[i],
+                        maxDistance[i], &out[i]);
+}
+
+#define RAYQUERY_BATCH 64
+
+void rayquery_lineOfSight(const f32 *fromX, const f32 *fromY, const f32 *toX,
+                          const f32 *toY, u8 *outClear, int count)
+{
+  f32 dirX[RAYQUERY_BATCH];
+  f32 dirY[RAYQUERY_BATCH];
+  f32 maxDistance[RAYQUERY_BATCH];
+  RayHit hits[RAYQUERY_BATCH];
+
+  for (int base = 0; base < count; base += RAYQUERY_BATCH)
+  {
+    int n = count - base;
+    if (n > RAYQUERY_BATCH)
+      n = RAYQUERY_BATCH;
+
+    // with dir = to - from the target sits at distance 1
+    for (int i = 0; i < n; ++i)
+    {
+      dirX[i] = toX[base + i] - fromX[base + i];
+      dirY[i] = toY[base + i] - fromY[base + i];
+      maxDistance[i] = 1.0f;
+    }
+    rayquery_cast(fromX + base, fromY + base, dirX, dirY, maxDistance, hits,
+                  n);
+    for (int i = 0; i < n; ++i)
+      outClear[base + i] = !hits[i].hit;
+  }
+}
@@ -1,7 +1,24 @@
+#include "automap.h"
+#include "dynlight.h"
 #include "engine.h"
+#include "postprocess.h"
 #include "raycast.h"
+#include "texcache.h"
+#include "upscale.h"
 #include "weapons.h"
 
+static f64 g_postMs = 0.0;
+
+/* Runs the post-process pass and keeps a smoothed timing of it for the
+ * debug HUD, so the stage can be measured in isolation. */
+static void applyPostProcess(Engine *engine) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  post_apply(engine);
+  Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+  f64 ms = (f64)elapsed * 1000.0 / (f64)SDL_GetPerformanceFrequency();
+  g_postMs = g_postMs * 0.9 + ms * 0.1;
+}
+
 void drawDebugHUD(Engine *engine) {
   // FPS counter
   renderInt(engine->game.Rbuffer, engine->font.debug, "FPS:", engine->fps, 10,
@@ -21,6 +38,35 @@ void drawDebugHUD(Engine *engine) {
   renderf32Pair(engine->game.Rbuffer, engine->font.debug,
                   "PLANE:", engine->player.planeX, engine->player.planeY, 10,
                   60, RGB_Yellow);
+  // present path
+  char present[64];
+  snprintf(present, sizeof(present), "PRESENT: %s x%d",
+           upscale_filterName(upscale_getFilter()), engine->game.swapCount);
+  renderText(engine->game.Rbuffer, engine->font.debug, present, 10, 75,
+             RGB_Yellow);
+  // post-process stage
+  char post[64];
+  if (post_isEnabled()) {
+    snprintf(post, sizeof(post), "POST: %.2f ms", g_postMs);
+  } else {
+    snprintf(post, sizeof(post), "POST: OFF");
+  }
+  renderText(engine->game.Rbuffer, engine->font.debug, post, 10, 90,
+             RGB_Yellow);
+  // dynamic lights
+  char lights[64];
+  snprintf(lights, sizeof(lights), "LIGHTS: %d/%d", dynlight_getCount(),
+           dynlight_getCap());
+  renderText(engine->game.Rbuffer, engine->font.debug, lights, 10, 105,
+             RGB_Yellow);
+  // streamed high-res textures
+  char tex[64];
+  snprintf(tex, sizeof(tex), "TEX: %d hi-res %.1f/%.1f MB",
+           texcache_getResidentCount(),
+           (f64)texcache_getResidentBytes() / (1024.0 * 1024.0),
+           (f64)texcache_getBudget() / (1024.0 * 1024.0));
+  renderText(engine->game.Rbuffer, engine->font.debug, tex, 10, 120,
+             RGB_Yellow);
 }
 
 void drawGameHUD(Engine *engine) {
@@ -36,16 +82,14 @@ void drawGameHUD(Engine *engine) {
 }
 
 void drawDebug(Engine *engine) {
-  /* 1. Clear Buffer */
+  /* 1. Lock the present texture and clear it */
+  beginFrame(&engine->game);
   clearBuffer(&engine->game);
 
   /* 2. Draw Game */
   perform_floorcasting(engine);
   perform_raycasting(engine);
 
-  if (!engine->game.buffer) {
-    fprintf(stderr, "[ERROR] game.buffer is NULL!\n");
-  }
   if (!engine->game.Rbuffer) {
     fprintf(stderr, "[ERROR] game.Rbuffer is NULL!\n");
   }
@@ -53,6 +97,7 @@ void drawDebug(Engine *engine) {
     fprintf(stderr, "[ERROR] game.Zbuffer is NULL!\n");
   }
   perform_spritecasting(engine);
+  applyPostProcess(engine);
   switch (engine->player.selectedGun) {
   case SHOTGUN:
     blitAnimation(engine->game.Rbuffer, &animations.shotgun_shoot, RENDER_WIDTH,
@@ -94,6 +139,8 @@ void drawDebug(Engine *engine) {
   default:
     break;
   }
+  automap_draw(engine->game.Rbuffer, engine->player.posX, engine->player.posY,
+               engine->player.dirX, engine->player.dirY);
   drawDebugHUD(engine);
   drawGameHUD(engine);
   drawBuffer(&engine->game);
@@ -101,16 +148,14 @@ void drawDebug(Engine *engine) {
 
 void drawGame(Engine *engine) {
 
-  /* 1. Clear Buffer */
+  /* 1. Lock the present texture and clear it */
+  beginFrame(&engine->game);
   clearBuffer(&engine->game);
 
   /* 2. Draw Game */
   perform_floorcasting(engine);
   perform_raycasting(engine);
 
-  if (!engine->game.buffer) {
-    fprintf(stderr, "[ERROR] game.buffer is NULL!\n");
-  }
   if (!engine->game.Rbuffer) {
     fprintf(stderr, "[ERROR] game.Rbuffer is NULL!\n");
   }
@@ -118,6 +163,7 @@ void drawGame(Engine *engine) {
     fprintf(stderr, "[ERROR] game.Zbuffer is NULL!\n");
   }
   perform_spritecasting(engine);
+  applyPostProcess(engine);
   switch (engine->player.selectedGun) {
   case SHOTGUN:
     blitAnimation(engine->game.Rbuffer, &animations.shotgun_shoot, RENDER_WIDTH,
@@ -159,6 +205,8 @@ void drawGame(Engine *engine) {
   default:
     break;
   }
+  automap_draw(engine->game.Rbuffer, engine->player.posX, engine->player.posY,
+               engine->player.dirX, engine->player.dirY);
   drawGameHUD(engine);
   drawBuffer(&engine->game);
 }
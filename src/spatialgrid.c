@@ -0,0 +1,202 @@
+#include "spatialgrid.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int spatialgrid_init(SpatialGrid *grid, i32 capacity)
+{
+  memset(grid, 0, sizeof(*grid));
+  for (i32 i = 0; i < SPATIAL_CELLS; ++i)
+    grid->head[i] = -1;
+  return spatialgrid_reserve(grid, capacity);
+}
+
+void spatialgrid_free(SpatialGrid *grid)
+{
+  free(grid->next);
+  free(grid->prev);
+  free(grid->cell);
+  grid->next = NULL;
+  grid->prev = NULL;
+  grid->cell = NULL;
+  grid->capacity = 0;
+}
+
+int spatialgrid_reserve(SpatialGrid *grid, i32 capacity)
+{
+  if (capacity <= grid->capacity)
+    return 0;
+
+  i32 *next = realloc(grid->next, (size_t)capacity * sizeof(i32));
+  if (next)
+    grid->next = next;
+  i32 *prev = realloc(grid->prev, (size_t)capacity * sizeof(i32));
+  if (prev)
+    grid->prev = prev;
+  i32 *cell = realloc(grid->cell, (size_t)capacity * sizeof(i32));
+  if (cell)
+    grid->cell = cell;
+  if (!next || !prev || !cell)
+  {
+    fprintf(stderr,
+            "\033[31m[ERROR] Failed to grow spatial grid to %d ids\033[0m\n",
+            capacity);
+    return -1;
+  }
+
+  for (i32 i = grid->capacity; i < capacity; ++i)
+    grid->cell[i] = -1;
+  grid->capacity = capacity;
+  return 0;
+}
+
+void spatialgrid_clear(SpatialGrid *grid)
+{
+  for (i32 i = 0; i < SPATIAL_CELLS; ++i)
+    grid->head[i] = -1;
+  for (i32 i = 0; i < grid->capacity; ++i)
+    grid->cell[i] = -1;
+}
+
+static void spatialgrid_unlink(SpatialGrid *grid, i32 id)
+{
+  i32 cell = grid->cell[id];
+  i32 prev = grid->prev[id];
+  i32 next = grid->next[id];
+  if (prev >= 0)
+    grid->next[prev] = next;
+  else
+    grid->head[cell] = next;
+  if (next >= 0)
+    grid->prev[next] = prev;
+  grid->cell[id] = -1;
+}
+
+void spatialgrid_update(SpatialGrid *grid, i32 id, f64 x, f64 y)
+{
+  if (id < 0 || id >= grid->capacity)
+    return;
+
+  i32 cell = spatialgrid_cellOf(x, y);
+  if (grid->cell[id] == cell)
+    return;
+  if (grid->cell[id] >= 0)
+    spatialgrid_unlink(grid, id);
+
+  i32 head = grid->head[cell];
+  grid->next[id] = head;
+  grid->prev[id] = -1;
+  if (head >= 0)
+    grid->prev[head] = id;
+  grid->head[cell] = id;
+  grid->cell[id] = cell;
+}
+
+void spatialgrid_remove(SpatialGrid *grid, i32 id)
+{
+  if (id < 0 || id >= grid->capacity || grid->cell[id] < 0)
+    return;
+  spatialgrid_unlink(grid, id);
+}
+
+static i32 spatialgrid_collectCell(const SpatialGrid *grid, i32 cellX,
+                                   i32 cellY, i32 *out, i32 count,
+                                   i32 maxOut)
+{
+  for (i32 id = spatialgrid_first(grid, cellX, cellY);
+       id >= 0 && count < maxOut; id = grid->next[id])
+    out[count++] = id;
+  return count;
+}
+
+i32 spatialgrid_queryRadius(const SpatialGrid *grid, f64 x, f64 y,
+                            f64 radius, i32 *out, i32 maxOut)
+{
+  i32 minX = (i32)floor(x - radius);
+  i32 maxX = (i32)floor(x + radius);
+  i32 minY = (i32)floor(y - radius);
+  i32 maxY = (i32)floor(y + radius);
+  minX = minX < 0 ? 0 : minX;
+  minY = minY < 0 ? 0 : minY;
+  maxX = maxX >= MAP_WIDTH ? MAP_WIDTH - 1 : maxX;
+  maxY = maxY >= MAP_HEIGHT ? MAP_HEIGHT - 1 : maxY;
+
+  i32 count = 0;
+  for (i32 cx = minX; cx <= maxX; ++cx)
+  {
+    for (i32 cy = minY; cy <= maxY; ++cy)
+      count = spatialgrid_collectCell(grid, cx, cy, out, count, maxOut);
+  }
+  return count;
+}
+
+static inline int spatialgrid_inMap(i32 x, i32 y)
+{
+  return x >= 0 && x < MAP_WIDTH && y >= 0 && y < MAP_HEIGHT;
+}
+
+i32 spatialgrid_queryRay(const SpatialGrid *grid, f64 originX, f64 originY,
+                         f64 dirX, f64 dirY, f64 maxDistance, i32 halfWidth,
+                         i32 *out, i32 maxOut)
+{
+  i32 mapX = (i32)floor(originX);
+  i32 mapY = (i32)floor(originY);
+  f64 deltaDistX = (dirX == 0.0) ? 1e30 : fabs(1.0 / dirX);
+  f64 deltaDistY = (dirY == 0.0) ? 1e30 : fabs(1.0 / dirY);
+  i32 stepX = (dirX < 0.0) ? -1 : 1;
+  i32 stepY = (dirY < 0.0) ? -1 : 1;
+  f64 sideDistX = (dirX < 0.0) ? (originX - mapX) * deltaDistX
+                               : (mapX + 1.0 - originX) * deltaDistX;
+  f64 sideDistY = (dirY < 0.0) ? (originY - mapY) * deltaDistY
+                               : (mapY + 1.0 - originY) * deltaDistY;
+
+  /* The ray moves monotonically, so a cell near the current one that was
+   * already near an earlier cell was also near the previous one; skipping
+   * those lists every id once without any per-query marks. */
+  i32 count = 0;
+  i32 prevX = 0;
+  i32 prevY = 0;
+  int havePrev = 0;
+  f64 crossing = 0.0;
+  const i32 limit = MAP_WIDTH + MAP_HEIGHT + 2 * halfWidth + 2;
+
+  for (i32 step = 0; step < limit && count < maxOut; ++step)
+  {
+    for (i32 nx = mapX - halfWidth; nx <= mapX + halfWidth; ++nx)
+    {
+      for (i32 ny = mapY - halfWidth; ny <= mapY + halfWidth; ++ny)
+      {
+        if (!spatialgrid_inMap(nx, ny))
+          continue;
+        if (havePrev && abs(nx - prevX) <= halfWidth &&
+            abs(ny - prevY) <= halfWidth)
+          continue;
+        count = spatialgrid_collectCell(grid, nx, ny, out, count, maxOut);
+      }
+    }
+    prevX = mapX;
+    prevY = mapY;
+    havePrev = 1;
+
+    if (sideDistX < sideDistY)
+    {
+      crossing = sideDistX;
+      sideDistX += deltaDistX;
+      mapX += stepX;
+    }
+    else
+    {
+      crossing = sideDistY;
+      sideDistY += deltaDistY;
+      mapY += stepY;
+    }
+    if (crossing > maxDistance)
+      break;
+    // fully past the map, widened cells included
+    if (mapX < -halfWidth || mapX >= MAP_WIDTH + halfWidth ||
+        mapY < -halfWidth || mapY >= MAP_HEIGHT + halfWidth)
+      break;
+  }
+  return count;
+}
@@ -1,12 +1,19 @@
 #include "sprites.h"
+#include "dynlight.h"
 #include "engine.h"
+#include "fog.h"
+#include "lightmap.h"
+#include "pvs.h"
 #include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
 
 typedef struct
 {
-  const u32 *pixels;
+  const pixel_t *pixels;
   i32 width;
   i32 height;
+  const MipChain *mips; // NULL when the source has no chain
 } SpriteFrame;
 
 SpriteAppearance spriteAppearanceFromTexture(i32 textureId)
@@ -25,10 +32,26 @@ SpriteAppearance spriteAppearanceFromAnimation(Animation *animation)
   return appearance;
 }
 
+// visible sprites of the frame, grown with the entity store
+static SpriteDepth *g_depths = NULL;
+static i32 g_depthCapacity = 0;
+
+static bool sprite_reserveDepths(i32 capacity)
+{
+  if (capacity <= g_depthCapacity)
+    return true;
+  SpriteDepth *grown = realloc(g_depths, (size_t)capacity * sizeof(*grown));
+  if (!grown)
+    return false;
+  g_depths = grown;
+  g_depthCapacity = capacity;
+  return true;
+}
+
 static int sprite_acquireFrame(const Sprite *sprite, const Engine *engine,
                                SpriteFrame *outFrame)
 {
-  if (!sprite || !engine || !outFrame || !sprite->active)
+  if (!sprite || !engine || !outFrame)
     return 0;
 
   if (sprite->appearance.type == SPRITE_VISUAL_TEXTURE)
@@ -37,13 +60,14 @@ static int sprite_acquireFrame(const Sprite *sprite, const Engine *engine,
     if (texIndex < 0 || texIndex >= NUM_TEXTURES)
       return 0;
 
-    const u32 *pixels = engine->textures.textures[texIndex];
+    const pixel_t *pixels = engine->textures.textures[texIndex];
     if (!pixels)
       return 0;
 
     outFrame->pixels = pixels;
     outFrame->width = TEXT_WIDTH;
     outFrame->height = TEXT_HEIGHT;
+    outFrame->mips = &engine->textures.mips[texIndex];
     return 1;
   }
 
@@ -64,45 +88,62 @@ static int sprite_acquireFrame(const Sprite *sprite, const Engine *engine,
     outFrame->pixels = frame->pixels;
     outFrame->width = frame->width;
     outFrame->height = frame->height;
+    outFrame->mips = &frame->mips;
     return 1;
   }
 
   return 0;
 }
 
-static int sprite_isTransparent(const Sprite *sprite, u32 color)
+static int sprite_isTransparent(const Sprite *sprite, pixel_t color)
 {
   if (sprite->appearance.type == SPRITE_VISUAL_ANIMATION)
   {
-    return (color & 0xFF000000u) == 0;
+    return !pixel_isOpaque(color);
   }
-  return (color & 0x00FFFFFFu) == 0;
+  return pixel_isColorKey(color);
 }
 
 void perform_spritecasting(Engine *engine)
 {
-  Sprite *sprites = engine->sprites;
-  i32 spriteOrder[NUM_SPRITES];
-  f64 spriteDistance[NUM_SPRITES];
-
-  for (i32 i = 0; i < NUM_SPRITES; ++i)
+  const EntityStore *entities = engine->entities;
+  if (!sprite_reserveDepths(entities->capacity))
+    return;
+  SpriteDepth *depths = g_depths;
+
+  /* Culling reads only the live lists and the position arrays; the cold
+   * record of a sprite is first touched once it is known to be drawn.
+   * Sprites on tiles outside the player's PVS never reach projection. */
+  i32 playerTileX = (i32)engine->player.posX;
+  i32 playerTileY = (i32)engine->player.posY;
+  i32 visibleCount = 0;
+  for (i32 kind = 0; kind < ENTITY_KIND_COUNT; ++kind)
   {
-    spriteOrder[i] = i;
-    f64 dx = engine->player.posX - sprites[i].x;
-    f64 dy = engine->player.posY - sprites[i].y;
-    spriteDistance[i] = dx * dx + dy * dy;
+    const i32 *live = entities->live[kind];
+    for (i32 n = 0; n < entities->liveCount[kind]; ++n)
+    {
+      i32 i = live[n];
+      if (!pvs_canSee(playerTileX, playerTileY, (i32)entities->x[i],
+                      (i32)entities->y[i]))
+        continue;
+
+      f64 dx = engine->player.posX - entities->x[i];
+      f64 dy = engine->player.posY - entities->y[i];
+      depths[visibleCount].index = i;
+      depths[visibleCount].distance = dx * dx + dy * dy;
+      ++visibleCount;
+    }
   }
 
-  sortSprites(spriteOrder, spriteDistance, NUM_SPRITES);
+  sortSprites(depths, visibleCount);
 
-  for (i32 i = 0; i < NUM_SPRITES; ++i)
+  for (i32 i = 0; i < visibleCount; ++i)
   {
-    Sprite *sprite = &sprites[spriteOrder[i]];
-    if (!sprite->active)
-      continue;
+    i32 index = depths[i].index;
+    const Sprite *sprite = &entities->cold[index];
 
-    f64 spriteX = sprite->x - engine->player.posX;
-    f64 spriteY = sprite->y - engine->player.posY;
+    f64 spriteX = entities->x[index] - engine->player.posX;
+    f64 spriteY = entities->y[index] - engine->player.posY;
 
     f64 det =
         engine->player.planeX * engine->player.dirY -
@@ -134,7 +175,8 @@ void perform_spritecasting(Engine *engine)
     if (frame.width <= 0 || frame.height <= 0)
       continue;
 
-    f64 projectedHeight = ((f64)RENDER_HEIGHT / transformY) * sprite->scale;
+    f64 projectedHeight =
+        ((f64)RENDER_HEIGHT / transformY) * entities->scale[index];
     i32 spriteHeight = (i32)fabs(projectedHeight);
     if (spriteHeight <= 0)
       continue;
@@ -146,6 +188,17 @@ void perform_spritecasting(Engine *engine)
     if (spriteWidth <= 0)
       continue;
 
+    // far sprites sample a smaller level instead of skipping through the
+    // full-size frame
+    if (frame.mips && frame.mips->levels > 1 &&
+        frame.mips->pixels[0] == frame.pixels)
+    {
+      i32 level = mip_selectLevel(frame.mips, spriteHeight);
+      frame.pixels = frame.mips->pixels[level];
+      frame.width = frame.mips->width[level];
+      frame.height = frame.mips->height[level];
+    }
+
     i32 spriteTop =
         -spriteHeight / 2 + RENDER_HEIGHT / 2 + (i32)engine->player.pitch;
     i32 spriteBottom =
@@ -162,6 +215,14 @@ void perform_spritecasting(Engine *engine)
     if (drawStartX > drawEndX || drawStartY > drawEndY)
       continue;
 
+    // sprites are unlit unless a dynamic light covers their tile
+    u32 dynLight =
+        dynlight_level((int)entities->x[index], (int)entities->y[index]);
+    u32 spriteLight = lightmap_addLevel(LIGHT_LEVEL_ONE, dynLight);
+    u32 fogWeight = fog_weight((f32)transformY);
+    if (fogWeight >= 256)
+      continue;
+
     f64 invSpriteWidth = 1.0 / (f64)spriteWidth;
     f64 invSpriteHeight = 1.0 / (f64)spriteHeight;
 
@@ -198,9 +259,12 @@ void perform_spritecasting(Engine *engine)
         if (texY >= frame.height)
           texY = frame.height - 1;
 
-        u32 color = frame.pixels[texY * frame.width + texX];
+        pixel_t color = frame.pixels[texY * frame.width + texX];
         if (sprite_isTransparent(sprite, color))
           continue;
+        if (dynLight)
+          color = lightmap_shade(color, spriteLight);
+        color = fog_blend(color, fogWeight);
 
         engine->game.Rbuffer[y * RENDER_WIDTH + stripe] = color;
       }
@@ -208,22 +272,18 @@ void perform_spritecasting(Engine *engine)
   }
 }
 
-void sortSprites(i32 *order, f64 *dist, i32 amount)
+// far to near, ties by index so the order does not depend on the sort
+static int sprite_compareDepth(const void *a, const void *b)
 {
-  for (i32 i = 1; i < amount; ++i)
-  {
-    i32 tempOrder = order[i];
-    f64 tempDist = dist[i];
-    i32 j = i - 1;
-
-    while (j >= 0 && dist[j] < tempDist)
-    {
-      order[j + 1] = order[j];
-      dist[j + 1] = dist[j];
-      --j;
-    }
+  const SpriteDepth *lhs = (const SpriteDepth *)a;
+  const SpriteDepth *rhs = (const SpriteDepth *)b;
+  if (lhs->distance != rhs->distance)
+    return lhs->distance < rhs->distance ? 1 : -1;
+  return (lhs->index > rhs->index) - (lhs->index < rhs->index);
+}
 
-    order[j + 1] = tempOrder;
-    dist[j + 1] = tempDist;
-  }
+void sortSprites(SpriteDepth *depths, i32 amount)
+{
+  if (amount > 1)
+    qsort(depths, (size_t)amount, sizeof(*depths), sprite_compareDepth);
 }
@@ -0,0 +1,360 @@
+#include "texcache.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+  TEXCACHE_LOWRES = 0, // only the resident low-res copy
+  TEXCACHE_QUEUED,     // high-res load requested or in flight
+  TEXCACHE_RESIDENT,   // high-res level installed
+  TEXCACHE_NATIVE,     // source is no larger than the low-res copy or failed
+  TEXCACHE_DEFERRED,   // loaded once but did not fit, waits for room
+} TexState;
+
+typedef struct
+{
+  TexState state;
+  pixel_t *pixels;
+  i32 width;
+  i32 height;
+  size_t bytes;
+  u32 lastUsed;
+  size_t deferredBytes; // size of the level that did not fit
+} TexEntry;
+
+typedef struct
+{
+  int id;
+  pixel_t *pixels;
+  i32 width;
+  i32 height;
+} TexResult;
+
+typedef struct
+{
+  const TextureManager *tm;
+  TexEntry entries[NUM_TEXTURES];
+  size_t budget;
+  size_t resident;
+  int residentCount;
+  u32 frame;
+
+  // loader thread, a texture is queued at most once so NUM_TEXTURES fits
+  SDL_Thread *thread;
+  SDL_mutex *lock;
+  SDL_cond *wake;
+  int quit;
+  int requests[NUM_TEXTURES];
+  int requestHead;
+  int requestCount;
+  TexResult results[NUM_TEXTURES];
+  int resultCount;
+} TexCache;
+
+static TexCache g_cache = {.budget = TEXCACHE_DEFAULT_BUDGET};
+
+static i32 texcache_log2(i32 v)
+{
+  i32 shift = 0;
+  while ((1 << (shift + 1)) <= v)
+    ++shift;
+  return shift;
+}
+
+static TextureView texcache_makeView(const pixel_t *pixels, i32 width,
+                                     i32 height)
+{
+  TextureView view;
+  view.pixels = pixels;
+  view.width = width;
+  view.height = height;
+  view.shiftX = texcache_log2(width);
+  view.shiftY = texcache_log2(height);
+  view.maskX = (u32)width - 1u;
+  view.maskY = (u32)height - 1u;
+  return view;
+}
+
+// the pack copy when one exists, otherwise the regular asset
+static void texcache_sourcePath(int id, char *out, size_t size)
+{
+  static const char prefix[] = "assets/textures/";
+  const char *path = getTexturePath(id);
+  snprintf(out, size, "%s", path ? path : "");
+  if (!path || strncmp(path, prefix, sizeof(prefix) - 1) != 0)
+    return;
+
+  char pack[256];
+  snprintf(pack, sizeof(pack), "%s%s", TEXCACHE_PACK_DIR,
+           path + sizeof(prefix) - 1);
+  FILE *file = fopen(pack, "rb");
+  if (file)
+  {
+    fclose(file);
+    snprintf(out, size, "%s", pack);
+  }
+}
+
+static int texcache_loader(void *data)
+{
+  (void)data;
+  SDL_LockMutex(g_cache.lock);
+  for (;;)
+  {
+    while (!g_cache.quit && g_cache.requestCount == 0)
+      SDL_CondWait(g_cache.wake, g_cache.lock);
+    if (g_cache.quit)
+      break;
+
+    int id = g_cache.requests[g_cache.requestHead];
+    g_cache.requestHead = (g_cache.requestHead + 1) % NUM_TEXTURES;
+    g_cache.requestCount--;
+    SDL_UnlockMutex(g_cache.lock);
+
+    char path[256];
+    texcache_sourcePath(id, path, sizeof(path));
+    TexResult result = {id, NULL, 0, 0};
+    result.pixels = loadImagePow2(path, TEXCACHE_MAX_SIZE, &result.width,
+                                  &result.height);
+    // nothing sharper than what is already resident
+    if (result.pixels && result.width <= TEXT_WIDTH &&
+        result.height <= TEXT_HEIGHT)
+    {
+      free(result.pixels);
+      result.pixels = NULL;
+    }
+
+    SDL_LockMutex(g_cache.lock);
+    g_cache.results[g_cache.resultCount++] = result;
+  }
+  SDL_UnlockMutex(g_cache.lock);
+  return 0;
+}
+
+int texcache_init(const TextureManager *tm)
+{
+  if (g_cache.lock)
+    return 0;
+
+  g_cache.tm = tm;
+  g_cache.lock = SDL_CreateMutex();
+  g_cache.wake = SDL_CreateCond();
+  if (!g_cache.lock || !g_cache.wake)
+  {
+    fprintf(stderr,
+            "\033[31m[ERROR] Texture cache: couldn't create locks: %s\033[0m\n",
+            SDL_GetError());
+    texcache_shutdown();
+    return 1;
+  }
+
+  g_cache.thread = SDL_CreateThread(texcache_loader, "texcache", NULL);
+  if (!g_cache.thread)
+  {
+    // still usable, everything just stays low-res
+    fprintf(stderr,
+            "\033[31m[ERROR] Texture cache: no loader thread: %s\033[0m\n",
+            SDL_GetError());
+    return 1;
+  }
+
+  printf("\033[32m[TEXCACHE] Streaming up to %dx%d, budget %.1f MB\033[0m\n",
+         TEXCACHE_MAX_SIZE, TEXCACHE_MAX_SIZE,
+         (double)g_cache.budget / (1024.0 * 1024.0));
+  return 0;
+}
+
+void texcache_shutdown(void)
+{
+  if (g_cache.thread)
+  {
+    SDL_LockMutex(g_cache.lock);
+    g_cache.quit = 1;
+    SDL_CondBroadcast(g_cache.wake);
+    SDL_UnlockMutex(g_cache.lock);
+    SDL_WaitThread(g_cache.thread, NULL);
+    g_cache.thread = NULL;
+  }
+
+  for (int i = 0; i < g_cache.resultCount; ++i)
+    free(g_cache.results[i].pixels);
+  for (int i = 0; i < NUM_TEXTURES; ++i)
+    free(g_cache.entries[i].pixels);
+
+  if (g_cache.wake)
+    SDL_DestroyCond(g_cache.wake);
+  if (g_cache.lock)
+    SDL_DestroyMutex(g_cache.lock);
+
+  size_t budget = g_cache.budget;
+  memset(&g_cache, 0, sizeof(g_cache));
+  g_cache.budget = budget;
+}
+
+static void texcache_request(int id)
+{
+  TexEntry *entry = &g_cache.entries[id];
+  entry->state = TEXCACHE_QUEUED;
+
+  SDL_LockMutex(g_cache.lock);
+  int tail = (g_cache.requestHead + g_cache.requestCount) % NUM_TEXTURES;
+  g_cache.requests[tail] = id;
+  g_cache.requestCount++;
+  SDL_CondSignal(g_cache.wake);
+  SDL_UnlockMutex(g_cache.lock);
+}
+
+TextureView texcache_view(int id)
+{
+  // ids come from level data; a bad one samples texture 0 and touches nothing
+  if (id < 0 || id >= NUM_TEXTURES)
+    return texcache_makeView(g_cache.tm->textures[0], TEXT_WIDTH,
+                             TEXT_HEIGHT);
+
+  TexEntry *entry = &g_cache.entries[id];
+  entry->lastUsed = g_cache.frame;
+
+  if (entry->state == TEXCACHE_RESIDENT)
+    return texcache_makeView(entry->pixels, entry->width, entry->height);
+
+  if (entry->state == TEXCACHE_LOWRES && g_cache.thread)
+    texcache_request(id);
+
+  return texcache_makeView(g_cache.tm->textures[id], TEXT_WIDTH, TEXT_HEIGHT);
+}
+
+static void texcache_evict(int id)
+{
+  TexEntry *entry = &g_cache.entries[id];
+  free(entry->pixels);
+  g_cache.resident -= entry->bytes;
+  g_cache.residentCount--;
+  entry->pixels = NULL;
+  entry->bytes = 0;
+  entry->state = TEXCACHE_LOWRES;
+}
+
+/* Evicts least recently used levels until `bytes` more fit the budget.
+ * Levels seen last frame are never evicted, so a budget smaller than
+ * the visible set degrades to low-res instead of reloading every frame. */
+static int texcache_makeRoom(size_t bytes)
+{
+  while (g_cache.resident + bytes > g_cache.budget)
+  {
+    int oldest = -1;
+    for (int i = 0; i < NUM_TEXTURES; ++i)
+    {
+      const TexEntry *entry = &g_cache.entries[i];
+      if (entry->state != TEXCACHE_RESIDENT ||
+          entry->lastUsed + 1 >= g_cache.frame)
+        continue;
+      if (oldest < 0 || entry->lastUsed < g_cache.entries[oldest].lastUsed)
+        oldest = i;
+    }
+    if (oldest < 0)
+      return 0;
+    texcache_evict(oldest);
+  }
+  return 1;
+}
+
+// bytes texcache_makeRoom could free right now
+static size_t texcache_reclaimable(void)
+{
+  size_t bytes = 0;
+  for (int i = 0; i < NUM_TEXTURES; ++i)
+  {
+    const TexEntry *entry = &g_cache.entries[i];
+    if (entry->state == TEXCACHE_RESIDENT &&
+        entry->lastUsed + 1 < g_cache.frame)
+      bytes += entry->bytes;
+  }
+  return bytes;
+}
+
+static void texcache_install(const TexResult *result)
+{
+  TexEntry *entry = &g_cache.entries[result->id];
+  if (!result->pixels)
+  {
+    entry->state = TEXCACHE_NATIVE;
+    return;
+  }
+
+  size_t bytes =
+      (size_t)result->width * (size_t)result->height * sizeof(pixel_t);
+  if (!texcache_makeRoom(bytes))
+  {
+    // no periodic reloads, texcache_update asks again once it would fit
+    free(result->pixels);
+    entry->state = TEXCACHE_DEFERRED;
+    entry->deferredBytes = bytes;
+    return;
+  }
+
+  entry->pixels = result->pixels;
+  entry->width = result->width;
+  entry->height = result->height;
+  entry->bytes = bytes;
+  entry->state = TEXCACHE_RESIDENT;
+  g_cache.resident += bytes;
+  g_cache.residentCount++;
+}
+
+void texcache_update(void)
+{
+  g_cache.frame++;
+  if (!g_cache.lock)
+    return;
+
+  TexResult done[NUM_TEXTURES];
+  SDL_LockMutex(g_cache.lock);
+  int count = g_cache.resultCount;
+  memcpy(done, g_cache.results, (size_t)count * sizeof(TexResult));
+  g_cache.resultCount = 0;
+  SDL_UnlockMutex(g_cache.lock);
+
+  for (int i = 0; i < count; ++i)
+    texcache_install(&done[i]);
+
+  // the budget may have shrunk since the last frame
+  texcache_makeRoom(0);
+
+  // deferred levels still in view load again once their size fits
+  if (!g_cache.thread)
+    return;
+  // what stays resident after makeRoom, plus what is already asked for
+  size_t committed = g_cache.resident - texcache_reclaimable();
+  for (int id = 0; id < NUM_TEXTURES; ++id)
+  {
+    TexEntry *entry = &g_cache.entries[id];
+    if (entry->state != TEXCACHE_DEFERRED ||
+        entry->lastUsed + 1 < g_cache.frame ||
+        committed + entry->deferredBytes > g_cache.budget)
+      continue;
+    committed += entry->deferredBytes;
+    texcache_request(id);
+  }
+}
+
+void texcache_setBudget(size_t bytes)
+{
+  g_cache.budget = bytes;
+}
+
+size_t texcache_getBudget(void)
+{
+  return g_cache.budget;
+}
+
+size_t texcache_getResidentBytes(void)
+{
+  return g_cache.resident;
+}
+
+int texcache_getResidentCount(void)
+{
+  return g_cache.residentCount;
+}
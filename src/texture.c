@@ -1,7 +1,9 @@
 #include "texture.h"
+#include "blit.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // create Object for Engine
@@ -12,7 +14,7 @@ TextureManager createTextures() {
 
 int textures_load(TextureManager *tm) {
   for (int i = 0; i < NUM_TEXTURES; i++) {
-    tm->textures[i] = malloc(TEXT_WIDTH * TEXT_HEIGHT * sizeof(u32));
+    tm->textures[i] = malloc(TEXT_WIDTH * TEXT_HEIGHT * sizeof(pixel_t));
     if (!tm->textures[i]) {
       fprintf(stderr, "\033[31mFailed to allocate texture:: %d\033[0m\n", i);
       free(tm->textures[i]);
@@ -21,15 +23,23 @@ int textures_load(TextureManager *tm) {
   }
 
   loadArrays(tm, TEXT_WIDTH, TEXT_HEIGHT);
+
+  // any texture can be placed as a sprite, so every one gets a mip chain
+  for (int i = 0; i < NUM_TEXTURES; i++)
+    mip_build(&tm->mips[i], tm->textures[i], TEXT_WIDTH, TEXT_HEIGHT,
+              MIP_KEY_COLOR);
   return 0;
 }
 
-void loadImage(u32 *texture, int width, int height, const char *filename) {
+int loadImage(pixel_t *texture, int width, int height, const char *filename) {
+  // a failed load leaves the texture black rather than uninitialised
+  memset(texture, 0, (size_t)width * (size_t)height * sizeof(pixel_t));
+
   SDL_Surface *surface = IMG_Load(filename);
   if (!surface) {
     fprintf(stderr, "\033[31mFailed to load %s: %s\033[0m\n", filename,
             IMG_GetError());
-    return;
+    return 1;
   }
 
   SDL_Surface *converted =
@@ -39,27 +49,75 @@ void loadImage(u32 *texture, int width, int height, const char *filename) {
   if (!converted) {
     fprintf(stderr, "\033[31m[ERROR] Failed to convert %s: %s\033[0m\n",
             filename, SDL_GetError());
-    return;
+    return 1;
   }
 
-  memset(texture, 0, (size_t)width * (size_t)height * sizeof(u32));
-
   u32 *pixels = (u32 *)converted->pixels;
   int srcPitch = converted->pitch / 4;
+  pixel_t *srcRow = NULL;
+  if (converted->w > 0 && converted->h > 0)
+    srcRow = malloc((size_t)converted->w * sizeof(pixel_t));
+  if (!srcRow) {
+    fprintf(stderr, "\033[31m[ERROR] Failed to load %s: empty image\033[0m\n",
+            filename);
+    SDL_FreeSurface(converted);
+    return 1;
+  }
+
+  int convertedY = -1;
   for (int y = 0; y < height; ++y) {
-    int srcY = (converted->h > 0) ? (y * converted->h) / height : 0;
-    if (srcY >= converted->h)
-      srcY = converted->h - 1;
-    for (int x = 0; x < width; ++x) {
-      int srcX = (converted->w > 0) ? (x * converted->w) / width : 0;
-      if (srcX >= converted->w)
-        srcX = converted->w - 1;
-      texture[y * width + x] = pixels[srcY * srcPitch + srcX];
+    int srcY = (y * converted->h) / height;
+    if (srcY != convertedY) {
+      const u32 *src = pixels + srcY * srcPitch;
+      for (int x = 0; x < converted->w; ++x)
+        srcRow[x] = pixel_fromARGB(src[x]);
+      convertedY = srcY;
     }
+    g_blit.scaleNearest(texture + y * width, srcRow, converted->w, width, 0,
+                        width);
   }
 
+  free(srcRow);
   SDL_FreeSurface(converted);
   printf("\033[32m[TEXTURE] Loaded texture: %s\033[0m\n", filename);
+  return 0;
+}
+
+static int floorPow2(int v) {
+  int p = 1;
+  while (p * 2 <= v)
+    p *= 2;
+  return p;
+}
+
+pixel_t *loadImagePow2(const char *filename, int maxSize, int *outWidth,
+                       int *outHeight) {
+  SDL_Surface *surface = IMG_Load(filename);
+  if (!surface) {
+    fprintf(stderr, "\033[31mFailed to load %s: %s\033[0m\n", filename,
+            IMG_GetError());
+    return NULL;
+  }
+
+  int width = floorPow2(surface->w > maxSize ? maxSize : surface->w);
+  int height = floorPow2(surface->h > maxSize ? maxSize : surface->h);
+  SDL_FreeSurface(surface);
+
+  pixel_t *pixels = malloc((size_t)width * (size_t)height * sizeof(pixel_t));
+  if (!pixels) {
+    fprintf(stderr, "\033[31m[ERROR] Couldn't allocate %dx%d texture\033[0m\n",
+            width, height);
+    return NULL;
+  }
+
+  // decodes the file a second time, fine off the render thread
+  if (loadImage(pixels, width, height, filename) != 0) {
+    free(pixels);
+    return NULL;
+  }
+  *outWidth = width;
+  *outHeight = height;
+  return pixels;
 }
 
 void loadArrays(TextureManager *tm, int texWidth, int texHeight) {
@@ -116,3 +174,20 @@ int getTextureIndexByName(const char *name) {
 
   return -1; // not found
 }
+
+const char *getTexturePath(int index) {
+  if (index < 0)
+    return NULL;
+  if (index < NUM_WALL_TEXTURES)
+    return wallTextures[index].path;
+  index -= NUM_WALL_TEXTURES;
+  if (index < NUM_DECOR_TEXTURES)
+    return decorTextures[index].path;
+  index -= NUM_DECOR_TEXTURES;
+  if (index < NUM_ENTITY_TEXTURES)
+    return entityTextures[index].path;
+  index -= NUM_ENTITY_TEXTURES;
+  if (index < NUM_DECAL_TEXTURES)
+    return decalTextures[index].path;
+  return NULL;
+}
@@ -0,0 +1,175 @@
+#include "threads.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+typedef struct
+{
+  SDL_Thread *threads[THREADS_MAX];
+  int count;
+
+  SDL_mutex *lock;
+  SDL_cond *wake; // new job published
+  SDL_cond *done; // last worker left the job
+  int generation;
+  int busy;
+  int quit;
+
+  // current job
+  ThreadJobFn fn;
+  void *ctx;
+  int total;
+  int chunkSize;
+  int chunkCount;
+  SDL_atomic_t nextChunk;
+} ThreadPool;
+
+static ThreadPool g_pool;
+
+static void pool_runChunks(void)
+{
+  for (;;)
+  {
+    int chunk = SDL_AtomicAdd(&g_pool.nextChunk, 1);
+    if (chunk >= g_pool.chunkCount)
+      break;
+
+    int begin = chunk * g_pool.chunkSize;
+    int end = begin + g_pool.chunkSize;
+    if (end > g_pool.total)
+      end = g_pool.total;
+    g_pool.fn(g_pool.ctx, begin, end);
+  }
+}
+
+static int pool_worker(void *data)
+{
+  (void)data;
+  int seen = 0;
+
+  SDL_LockMutex(g_pool.lock);
+  for (;;)
+  {
+    while (!g_pool.quit && g_pool.generation == seen)
+      SDL_CondWait(g_pool.wake, g_pool.lock);
+    if (g_pool.quit)
+      break;
+    seen = g_pool.generation;
+    SDL_UnlockMutex(g_pool.lock);
+
+    pool_runChunks();
+
+    SDL_LockMutex(g_pool.lock);
+    if (--g_pool.busy == 0)
+      SDL_CondSignal(g_pool.done);
+  }
+  SDL_UnlockMutex(g_pool.lock);
+  return 0;
+}
+
+int threads_init(int workerCount)
+{
+  if (g_pool.lock)
+    return 0;
+
+  // default: one worker per core, the calling thread is the last one
+  if (workerCount <= 0)
+    workerCount = SDL_GetCPUCount() - 1;
+  if (workerCount > THREADS_MAX)
+    workerCount = THREADS_MAX;
+
+  g_pool.lock = SDL_CreateMutex();
+  g_pool.wake = SDL_CreateCond();
+  g_pool.done = SDL_CreateCond();
+  if (!g_pool.lock || !g_pool.wake || !g_pool.done)
+  {
+    fprintf(stderr, "\033[31m[ERROR] Failed to create thread pool: %s\033[0m\n",
+            SDL_GetError());
+    threads_shutdown();
+    return 1;
+  }
+
+  g_pool.count = 0;
+  g_pool.generation = 0;
+  g_pool.quit = 0;
+  for (int i = 0; i < workerCount; ++i)
+  {
+    SDL_Thread *thread = SDL_CreateThread(pool_worker, "worker", NULL);
+    if (!thread)
+    {
+      fprintf(stderr,
+              "\033[33m[WARN] Failed to start worker thread: %s\033[0m\n",
+              SDL_GetError());
+      break;
+    }
+    g_pool.threads[g_pool.count++] = thread;
+  }
+
+  printf("\033[32m[THREADS] %d worker threads started...\033[0m\n",
+         g_pool.count);
+  return 0;
+}
+
+void threads_shutdown(void)
+{
+  if (g_pool.lock)
+  {
+    SDL_LockMutex(g_pool.lock);
+    g_pool.quit = 1;
+    SDL_CondBroadcast(g_pool.wake);
+    SDL_UnlockMutex(g_pool.lock);
+  }
+
+  for (int i = 0; i < g_pool.count; ++i)
+    SDL_WaitThread(g_pool.threads[i], NULL);
+  g_pool.count = 0;
+
+  if (g_pool.done)
+    SDL_DestroyCond(g_pool.done);
+  if (g_pool.wake)
+    SDL_DestroyCond(g_pool.wake);
+  if (g_pool.lock)
+    SDL_DestroyMutex(g_pool.lock);
+  g_pool.done = NULL;
+  g_pool.wake = NULL;
+  g_pool.lock = NULL;
+}
+
+int threads_getWorkerCount(void)
+{
+  return g_pool.count;
+}
+
+void threads_parallelFor(int count, ThreadJobFn fn, void *ctx)
+{
+  if (count <= 0 || !fn)
+    return;
+
+  if (g_pool.count == 0 || count == 1)
+  {
+    fn(ctx, 0, count);
+    return;
+  }
+
+  int parts = (g_pool.count + 1) * THREADS_CHUNKS_PER_THREAD;
+  int chunkSize = (count + parts - 1) / parts;
+
+  SDL_LockMutex(g_pool.lock);
+  g_pool.fn = fn;
+  g_pool.ctx = ctx;
+  g_pool.total = count;
+  g_pool.chunkSize = chunkSize;
+  g_pool.chunkCount = (count + chunkSize - 1) / chunkSize;
+  SDL_AtomicSet(&g_pool.nextChunk, 0);
+  g_pool.busy = g_pool.count;
+  g_pool.generation++;
+  SDL_CondBroadcast(g_pool.wake);
+  SDL_UnlockMutex(g_pool.lock);
+
+  // the calling thread helps instead of just waiting
+  pool_runChunks();
+
+  SDL_LockMutex(g_pool.lock);
+  while (g_pool.busy > 0)
+    SDL_CondWait(g_pool.done, g_pool.lock);
+  SDL_UnlockMutex(g_pool.lock);
+}
@@ -0,0 +1,465 @@
+#include "upscale.h"
+#include "blit.h"
+#include "threads.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct
+{
+  UpscaleFilter filter;
+  SDL_Texture *textures[SWAP_MAX]; // window sized, one per swap slot
+  int width;
+  int height;
+  // sharp bilinear sample tables, one entry per output column / row
+  i32 *xIndex;
+  u32 *xWeight;
+  i32 *yIndex;
+  u32 *yWeight;
+} UpscaleState;
+
+typedef struct
+{
+  const u32 *src;
+  Uint8 *dst;
+  int pitch;
+  int width;
+  int height;
+  UpscaleFilter filter;
+  int scale;
+  int offX;
+  int offY;
+} UpscaleJob;
+
+static UpscaleState g_upscale = {UPSCALE_SDL, {NULL}, 0, 0,
+                                 NULL,        NULL,   NULL, NULL};
+
+static const char *g_filterNames[UPSCALE_TOTAL] = {
+    "SDL",
+    "Nearest",
+    "Sharp bilinear",
+    "Scanline",
+};
+
+// w in [0, 256], two channels per multiply
+static inline u32 upscale_lerp(u32 a, u32 b, u32 w)
+{
+  u32 inv = 256u - w;
+  u32 rb = (((a & 0x00FF00FFu) * inv + (b & 0x00FF00FFu) * w) >> 8) &
+           0x00FF00FFu;
+  u32 ag = (((a >> 8) & 0x00FF00FFu) * inv + ((b >> 8) & 0x00FF00FFu) * w) &
+           0xFF00FF00u;
+  return ag | rb;
+}
+
+static void upscale_lerpRow(u32 *dst, const u32 *a, const u32 *b, u32 w,
+                            int count)
+{
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wb = _mm_set1_epi16((short)w);
+  const __m128i wa = _mm_set1_epi16((short)(256u - w));
+  for (; x + 4 <= count; x += 4)
+  {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+    lo = _mm_srli_epi16(lo, 8);
+    hi = _mm_srli_epi16(hi, 8);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; x < count; ++x)
+    dst[x] = upscale_lerp(a[x], b[x], w);
+}
+
+/* Horizontal pass through the axis tables: dst[x] blends src[index[x]]
+ * with its right neighbour by weight[x]. */
+static void upscale_sampleRow(u32 *dst, const u32 *src, const i32 *index,
+                              const u32 *weight, int count)
+{
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(256);
+  for (; x + 4 <= count; x += 4)
+  {
+    const i32 *i0 = index + x;
+    __m128i va = _mm_set_epi32((int)src[i0[3]], (int)src[i0[2]],
+                               (int)src[i0[1]], (int)src[i0[0]]);
+    __m128i vb = _mm_set_epi32((int)src[i0[3] + 1], (int)src[i0[2] + 1],
+                               (int)src[i0[1] + 1], (int)src[i0[0] + 1]);
+
+    // w0 w1 w2 w3 as 16 bit, then each spread over its pixel's 4 channels
+    __m128i w = _mm_loadu_si128((const __m128i *)(weight + x));
+    w = _mm_packs_epi32(w, w);
+    w = _mm_unpacklo_epi16(w, w);
+    __m128i wbLo = _mm_unpacklo_epi32(w, w);
+    __m128i wbHi = _mm_unpackhi_epi32(w, w);
+    __m128i waLo = _mm_sub_epi16(full, wbLo);
+    __m128i waHi = _mm_sub_epi16(full, wbHi);
+
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), waLo),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wbLo));
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), waHi),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wbHi));
+    lo = _mm_srli_epi16(lo, 8);
+    hi = _mm_srli_epi16(hi, 8);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; x < count; ++x)
+    dst[x] = upscale_lerp(src[index[x]], src[index[x] + 1], weight[x]);
+}
+
+// half brightness, same shade the raycaster uses for side walls
+static void upscale_darkenRow(u32 *dst, const u32 *src, int count)
+{
+#ifdef PIXEL_RGB565
+  // 16 bit builds always present through SDL, kept for the shared job code
+  for (int x = 0; x < count; ++x)
+    dst[x] = ((src[x] >> 1) & 0x007F7F7Fu) | 0xFF000000u;
+#else
+  g_blit.shadeHalf(dst, src, count);
+#endif
+}
+
+// repeats every source pixel `scale` times
+static void upscale_expandRow(u32 *dst, const u32 *src, int count, int scale)
+{
+  int x = 0;
+#if defined(__SSE2__)
+  if (scale == 2)
+  {
+    for (; x + 4 <= count; x += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+      _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi32(v, v));
+      _mm_storeu_si128((__m128i *)(dst + x * 2 + 4), _mm_unpackhi_epi32(v, v));
+    }
+  }
+  else if (scale == 4)
+  {
+    for (; x + 4 <= count; x += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+      u32 *out = dst + x * 4;
+      _mm_storeu_si128((__m128i *)(out + 0), _mm_shuffle_epi32(v, 0x00));
+      _mm_storeu_si128((__m128i *)(out + 4), _mm_shuffle_epi32(v, 0x55));
+      _mm_storeu_si128((__m128i *)(out + 8), _mm_shuffle_epi32(v, 0xAA));
+      _mm_storeu_si128((__m128i *)(out + 12), _mm_shuffle_epi32(v, 0xFF));
+    }
+  }
+  else if (scale > 4)
+  {
+    for (; x < count; ++x)
+    {
+      __m128i v = _mm_set1_epi32((int)src[x]);
+      u32 *out = dst + x * scale;
+      int i = 0;
+      for (; i + 4 <= scale; i += 4)
+        _mm_storeu_si128((__m128i *)(out + i), v);
+      for (; i < scale; ++i)
+        out[i] = src[x];
+    }
+  }
+#endif
+  for (; x < count; ++x)
+  {
+    u32 color = src[x];
+    u32 *out = dst + x * scale;
+    for (int i = 0; i < scale; ++i)
+      out[i] = color;
+  }
+}
+
+static void upscale_integerRows(void *ctx, int begin, int end)
+{
+  const UpscaleJob *job = (const UpscaleJob *)ctx;
+  const int scale = job->scale;
+  const int imageW = RENDER_WIDTH * scale;
+  const int imageH = RENDER_HEIGHT * scale;
+  const int right = job->width - job->offX - imageW;
+  u32 shaded[RENDER_WIDTH];
+
+  for (int y = begin; y < end; ++y)
+  {
+    u32 *row = (u32 *)(job->dst + (size_t)y * (size_t)job->pitch);
+    int localY = y - job->offY;
+    if (localY < 0 || localY >= imageH)
+    {
+      memset(row, 0, (size_t)job->width * sizeof(u32));
+      continue;
+    }
+
+    if (job->offX > 0)
+      memset(row, 0, (size_t)job->offX * sizeof(u32));
+    if (right > 0)
+      memset(row + job->offX + imageW, 0, (size_t)right * sizeof(u32));
+
+    int srcY = localY / scale;
+    const u32 *src = job->src + srcY * RENDER_WIDTH;
+
+    // last output row of every source row is the dark scanline
+    if (job->filter == UPSCALE_SCANLINE && scale >= 2 &&
+        localY - srcY * scale == scale - 1)
+    {
+      upscale_darkenRow(shaded, src, RENDER_WIDTH);
+      src = shaded;
+    }
+
+    upscale_expandRow(row + job->offX, src, RENDER_WIDTH, scale);
+  }
+}
+
+static void upscale_bilinearRows(void *ctx, int begin, int end)
+{
+  const UpscaleJob *job = (const UpscaleJob *)ctx;
+  u32 blended[RENDER_WIDTH + 1];
+  int cachedIndex = -1;
+  u32 cachedWeight = 0;
+
+  for (int y = begin; y < end; ++y)
+  {
+    // vertical pass once per distinct (row, weight) pair
+    int y0 = g_upscale.yIndex[y];
+    u32 wy = g_upscale.yWeight[y];
+    if (y0 != cachedIndex || wy != cachedWeight)
+    {
+      const u32 *a = job->src + y0 * RENDER_WIDTH;
+      const u32 *b = (y0 + 1 < RENDER_HEIGHT) ? a + RENDER_WIDTH : a;
+      upscale_lerpRow(blended, a, b, wy, RENDER_WIDTH);
+      blended[RENDER_WIDTH] = blended[RENDER_WIDTH - 1];
+      cachedIndex = y0;
+      cachedWeight = wy;
+    }
+
+    u32 *row = (u32 *)(job->dst + (size_t)y * (size_t)job->pitch);
+    upscale_sampleRow(row, blended, g_upscale.xIndex, g_upscale.xWeight,
+                      job->width);
+  }
+}
+
+/* Sharp bilinear: nearest inside each texel, bilinear only across a band
+ * of about one output pixel at texel edges (prescale = integer scale). */
+static void upscale_buildAxis(i32 *index, u32 *weight, int outSize,
+                              int srcSize)
+{
+  double scale = (double)outSize / (double)srcSize;
+  double prescale = floor(scale);
+  if (prescale < 1.0)
+    prescale = 1.0;
+  double region = 0.5 - 0.5 / prescale;
+
+  for (int i = 0; i < outSize; ++i)
+  {
+    double texel = ((double)i + 0.5) / scale;
+    double base = floor(texel);
+    double center = texel - base - 0.5;
+    double clamped = center;
+    if (clamped < -region)
+      clamped = -region;
+    if (clamped > region)
+      clamped = region;
+
+    double pos = base + (center - clamped) * prescale;
+    int i0 = (int)floor(pos);
+    u32 w = (u32)((pos - (double)i0) * 256.0 + 0.5);
+    if (w >= 256u)
+    {
+      i0++;
+      w = 0;
+    }
+    if (i0 < 0)
+    {
+      i0 = 0;
+      w = 0;
+    }
+    if (i0 >= srcSize - 1)
+    {
+      i0 = srcSize - 1;
+      w = 0;
+    }
+    index[i] = i0;
+    weight[i] = w;
+  }
+}
+
+static void upscale_releaseTarget(void)
+{
+  for (int i = 0; i < SWAP_MAX; ++i)
+  {
+    if (g_upscale.textures[i])
+    {
+      SDL_DestroyTexture(g_upscale.textures[i]);
+      g_upscale.textures[i] = NULL;
+    }
+  }
+  free(g_upscale.xIndex);
+  free(g_upscale.xWeight);
+  free(g_upscale.yIndex);
+  free(g_upscale.yWeight);
+  g_upscale.xIndex = NULL;
+  g_upscale.xWeight = NULL;
+  g_upscale.yIndex = NULL;
+  g_upscale.yWeight = NULL;
+  g_upscale.width = 0;
+  g_upscale.height = 0;
+}
+
+static SDL_Texture *upscale_acquireTarget(Game *game, int width, int height)
+{
+  if (width != g_upscale.width || height != g_upscale.height)
+  {
+    upscale_releaseTarget();
+
+    g_upscale.xIndex = malloc((size_t)width * sizeof(i32));
+    g_upscale.xWeight = malloc((size_t)width * sizeof(u32));
+    g_upscale.yIndex = malloc((size_t)height * sizeof(i32));
+    g_upscale.yWeight = malloc((size_t)height * sizeof(u32));
+    if (!g_upscale.xIndex || !g_upscale.xWeight || !g_upscale.yIndex ||
+        !g_upscale.yWeight)
+    {
+      fprintf(stderr, "\033[31m[ERROR] Couldn't allocate upscale tables\033[0m\n");
+      upscale_releaseTarget();
+      return NULL;
+    }
+    upscale_buildAxis(g_upscale.xIndex, g_upscale.xWeight, width, RENDER_WIDTH);
+    upscale_buildAxis(g_upscale.yIndex, g_upscale.yWeight, height,
+                      RENDER_HEIGHT);
+    g_upscale.width = width;
+    g_upscale.height = height;
+  }
+
+  SDL_Texture **slot = &g_upscale.textures[game->swapIndex];
+  if (!*slot)
+  {
+    *slot = SDL_CreateTexture(game->renderer, SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!*slot)
+      fprintf(stderr,
+              "\033[31m[ERROR] Failed to create upscale texture: %s\033[0m\n",
+              SDL_GetError());
+  }
+  return *slot;
+}
+
+void upscale_setSwapCount(int count)
+{
+  // slots past the new count are never presented again
+  for (int i = count < 0 ? 0 : count; i < SWAP_MAX; ++i)
+  {
+    if (g_upscale.textures[i])
+    {
+      SDL_DestroyTexture(g_upscale.textures[i]);
+      g_upscale.textures[i] = NULL;
+    }
+  }
+}
+
+int upscale_init(Game *game)
+{
+  // the software renderer's stretch is the slowest part of a frame there
+  SDL_RendererInfo info;
+  if (game && game->renderer && SDL_GetRendererInfo(game->renderer, &info) == 0 &&
+      (info.flags & SDL_RENDERER_SOFTWARE))
+    upscale_setFilter(UPSCALE_NEAREST);
+
+  printf("\033[32m[UPSCALE] Filter: %s\033[0m\n",
+         g_filterNames[g_upscale.filter]);
+  return 0;
+}
+
+void upscale_cleanup(void)
+{
+  upscale_releaseTarget();
+}
+
+void upscale_setFilter(UpscaleFilter filter)
+{
+  if (filter < 0 || filter >= UPSCALE_TOTAL)
+    filter = UPSCALE_SDL;
+#ifdef PIXEL_RGB565
+  // the kernels are ARGB8888 only, 16 bit frames are stretched by SDL
+  filter = UPSCALE_SDL;
+#endif
+  g_upscale.filter = filter;
+}
+
+UpscaleFilter upscale_getFilter(void)
+{
+  return g_upscale.filter;
+}
+
+int upscale_isActive(void)
+{
+  return g_upscale.filter != UPSCALE_SDL;
+}
+
+const char *upscale_filterName(UpscaleFilter filter)
+{
+  if (filter < 0 || filter >= UPSCALE_TOTAL)
+    return "?";
+  return g_filterNames[filter];
+}
+
+int upscale_present(Game *game)
+{
+  if (!game || !game->Rbuffer || !upscale_isActive())
+    return 1;
+
+  int width = game->window_width;
+  int height = game->window_height;
+  if (SDL_GetRendererOutputSize(game->renderer, &width, &height) != 0)
+  {
+    width = game->window_width;
+    height = game->window_height;
+  }
+  if (width <= 0 || height <= 0)
+    return 1;
+
+  SDL_Texture *target = upscale_acquireTarget(game, width, height);
+  if (!target)
+    return 1;
+
+  void *pixels = NULL;
+  int pitch = 0;
+  if (SDL_LockTexture(target, NULL, &pixels, &pitch) != 0)
+    return 1;
+
+  UpscaleJob job;
+  job.src = (const u32 *)game->Rbuffer;
+  job.dst = (Uint8 *)pixels;
+  job.pitch = pitch;
+  job.width = width;
+  job.height = height;
+  job.filter = g_upscale.filter;
+  job.scale = width / RENDER_WIDTH;
+  if (height / RENDER_HEIGHT < job.scale)
+    job.scale = height / RENDER_HEIGHT;
+  job.offX = (width - RENDER_WIDTH * job.scale) / 2;
+  job.offY = (height - RENDER_HEIGHT * job.scale) / 2;
+
+  // window smaller than the render target: integer modes can't fit, blend
+  if (job.filter == UPSCALE_SHARP_BILINEAR || job.scale < 1)
+    threads_parallelFor(height, upscale_bilinearRows, &job);
+  else
+    threads_parallelFor(height, upscale_integerRows, &job);
+
+  SDL_UnlockTexture(target);
+  SDL_RenderCopy(game->renderer, target, NULL, NULL);
+  return 0;
+}
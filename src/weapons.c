@@ -1,9 +1,9 @@
 #include "weapons.h"
 
 WeaponProperties weaponProperties[TOTAL_GUNS] = {
-    {0, 0.0, 0.0, 100, 55},                     // 0 semi: SHOTGUN
-    {0, 0.0, 0.0, 50, 140},                     // 1 semi: ROCKET
-    {0, 0.0, 0.0, 150, 20},                     // 2 semi: PISTOL
-    {0, 0.0, 0.0, 80, 35},                      // 3 semi: SINGLE
-    {1, FRAMETIME_MINIGUN_SHOOT, 0.0, 500, 8},  // 4 automatic: MINIGUN
+    {0, 0.0, 0.0, 100, 55, 12, 0.14},                   // 0 semi: SHOTGUN
+    {0, 0.0, 0.0, 50, 140, 1, 0.0},                     // 1 semi: ROCKET
+    {0, 0.0, 0.0, 150, 20, 1, 0.0},                     // 2 semi: PISTOL
+    {0, 0.0, 0.0, 80, 35, 8, 0.10},                     // 3 semi: SINGLE
+    {1, FRAMETIME_MINIGUN_SHOOT, 0.0, 500, 8, 1, 0.0},  // 4 automatic: MINIGUN
 };
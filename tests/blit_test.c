@@ -0,0 +1,307 @@
+// Every blit kernel at every level against a plain reference: make blit_test
+#include "blit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_ROW 96       // longest row, covers the 8/16 wide loops and tails
+#define TEST_GUARD 8      // untouched pixels around every row
+#define TEST_ROUNDS 4000  // random rows per kernel and level
+#define TEST_SCALE_SRC 4096
+#define TEST_LUT_BITS 6
+#ifdef PIXEL_RGB565
+#define TEST_LUT_ENTRIES 65536
+#else
+#define TEST_LUT_ENTRIES (1 << (3 * TEST_LUT_BITS))
+#endif
+
+static pixel_t g_src[TEST_ROW + 2 * TEST_GUARD];
+static u32 g_argb[TEST_ROW + 2 * TEST_GUARD];
+static pixel_t g_start[TEST_ROW + 2 * TEST_GUARD];
+static pixel_t g_expected[TEST_ROW + 2 * TEST_GUARD];
+static pixel_t g_actual[TEST_ROW + 2 * TEST_GUARD];
+static pixel_t g_scaleSrc[TEST_SCALE_SRC];
+static pixel_t g_scaleExpected[TEST_SCALE_SRC + 2 * TEST_GUARD];
+static pixel_t g_scaleActual[TEST_SCALE_SRC + 2 * TEST_GUARD];
+static pixel_t g_lut[TEST_LUT_ENTRIES];
+
+static u32 test_rand(u32 *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+static u32 test_rand32(u32 *state)
+{
+  return (test_rand(state) << 16) ^ test_rand(state);
+}
+
+// mostly opaque, some transparent and some in between
+static u32 test_randARGB(u32 *state)
+{
+  u32 c = test_rand32(state);
+  switch (test_rand(state) & 3u)
+  {
+  case 0:
+    return c & 0x00FFFFFFu;
+  case 1:
+    return c | 0xFF000000u;
+  default:
+    return c;
+  }
+}
+
+/* References, written from the contracts in blit.h */
+
+static void ref_clear(pixel_t *dst, pixel_t value, int count)
+{
+  for (int i = 0; i < count; ++i)
+    dst[i] = value;
+}
+
+static void ref_copyKeyed(pixel_t *dst, const pixel_t *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+    dst[i] = pixel_isOpaque(src[i]) ? src[i] : dst[i];
+}
+
+static u32 ref_blendChannel(u32 s, u32 d, u32 a)
+{
+  return (s * a + d * (255u - a) + 127u) / 255u;
+}
+
+static void ref_blendAlpha(pixel_t *dst, const u32 *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    u32 a = src[i] >> 24;
+    if (a == 0)
+      continue;
+    u32 d = pixel_toARGB(dst[i]);
+    u32 out = 0xFF000000u;
+    for (int shift = 0; shift < 24; shift += 8)
+      out |= ref_blendChannel((src[i] >> shift) & 0xFFu, (d >> shift) & 0xFFu,
+                              a)
+             << shift;
+    dst[i] = pixel_fromARGB(out);
+  }
+}
+
+static void ref_scaleNearest(pixel_t *dst, const pixel_t *src, int srcCount,
+                             int dstCount, int first, int count)
+{
+  for (int i = 0; i < count; ++i)
+    dst[i] = src[(i64)(first + i) * srcCount / dstCount];
+}
+
+static void ref_shadeHalf(pixel_t *dst, const pixel_t *src, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+#ifdef PIXEL_RGB565
+    // every channel loses its low bit, then halves
+    dst[i] = (pixel_t)((src[i] >> 1) & 0x7BEFu);
+#else
+    u32 c = src[i];
+    dst[i] = 0xFF000000u | (((c >> 16) & 0xFFu) >> 1) << 16 |
+             (((c >> 8) & 0xFFu) >> 1) << 8 | ((c & 0xFFu) >> 1);
+#endif
+  }
+}
+
+static void ref_gradeLUT(pixel_t *dst, const pixel_t *lut, int bits,
+                         int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+#ifdef PIXEL_RGB565
+    (void)bits;
+    dst[i] = lut[dst[i]];
+#else
+    u32 c = dst[i];
+    u32 index = 0;
+    // blue, green, red from the top, `bits` each
+    for (int shift = 0; shift < 24; shift += 8)
+      index = (index << bits) | (((c >> shift) & 0xFFu) >> (8 - bits));
+    dst[i] = lut[index];
+#endif
+  }
+}
+
+static int test_report(const char *kernel, BlitLevel level, int count,
+                       int offset)
+{
+  printf("  %s %s: mismatch at count %d offset %d\n", blit_levelName(level),
+         kernel, count, offset);
+  return 1;
+}
+
+static void test_fillRows(u32 *seed)
+{
+  for (int i = 0; i < TEST_ROW + 2 * TEST_GUARD; ++i)
+  {
+    g_src[i] = pixel_fromARGB(test_randARGB(seed));
+    g_argb[i] = test_randARGB(seed);
+    g_start[i] = pixel_fromARGB(test_rand32(seed) | 0xFF000000u);
+  }
+}
+
+static void test_resetDst(void)
+{
+  memcpy(g_expected, g_start, sizeof(g_start));
+  memcpy(g_actual, g_start, sizeof(g_start));
+}
+
+// random rows of every length up to TEST_ROW at every misalignment
+static int test_rowKernels(const BlitKernels *k, u32 *seed)
+{
+  int failures = 0;
+  for (int round = 0; round < TEST_ROUNDS; ++round)
+  {
+    test_fillRows(seed);
+    int count = round % (TEST_ROW + 1);
+    int offset = TEST_GUARD - 3 + (int)(test_rand(seed) % 7u);
+    pixel_t *exp = g_expected + offset;
+    pixel_t *act = g_actual + offset;
+
+    test_resetDst();
+    ref_clear(exp, g_src[0], count);
+    k->clear(act, g_src[0], count);
+    if (memcmp(g_expected, g_actual, sizeof(g_actual)) != 0)
+      failures += test_report("clear", k->level, count, offset);
+
+    test_resetDst();
+    ref_copyKeyed(exp, g_src + offset, count);
+    k->copyKeyed(act, g_src + offset, count);
+    if (memcmp(g_expected, g_actual, sizeof(g_actual)) != 0)
+      failures += test_report("copyKeyed", k->level, count, offset);
+
+    test_resetDst();
+    ref_blendAlpha(exp, g_argb + offset, count);
+    k->blendAlpha(act, g_argb + offset, count);
+    if (memcmp(g_expected, g_actual, sizeof(g_actual)) != 0)
+      failures += test_report("blendAlpha", k->level, count, offset);
+
+    test_resetDst();
+    ref_shadeHalf(exp, g_src + offset, count);
+    k->shadeHalf(act, g_src + offset, count);
+    if (memcmp(g_expected, g_actual, sizeof(g_actual)) != 0)
+      failures += test_report("shadeHalf", k->level, count, offset);
+
+    // a fresh random row as the image, graded in place
+    memcpy(g_expected, g_src, sizeof(g_src));
+    memcpy(g_actual, g_src, sizeof(g_src));
+    ref_gradeLUT(exp, g_lut, TEST_LUT_BITS, count);
+    k->gradeLUT(act, g_lut, TEST_LUT_BITS, count);
+    if (memcmp(g_expected, g_actual, sizeof(g_actual)) != 0)
+      failures += test_report("gradeLUT", k->level, count, offset);
+
+    if (failures > 8)
+      break;
+  }
+  return failures;
+}
+
+// up and down scales, whole rows and clipped spans
+static int test_scaleNearest(const BlitKernels *k, u32 *seed)
+{
+  for (int i = 0; i < TEST_SCALE_SRC; ++i)
+    g_scaleSrc[i] = pixel_fromARGB(test_rand32(seed));
+
+  for (int round = 0; round < TEST_ROUNDS; ++round)
+  {
+    int srcCount = 1 + (int)(test_rand(seed) % TEST_SCALE_SRC);
+    int dstCount = 1 + (int)(test_rand(seed) % TEST_SCALE_SRC);
+    if (round & 1)
+      srcCount = 1 + (int)(test_rand(seed) % 64u);
+    int first = (int)(test_rand(seed) % (u32)dstCount);
+    int count = (int)(test_rand(seed) % (u32)(dstCount - first + 1));
+
+    memset(g_scaleExpected, 0, sizeof(g_scaleExpected));
+    memset(g_scaleActual, 0, sizeof(g_scaleActual));
+    ref_scaleNearest(g_scaleExpected + TEST_GUARD, g_scaleSrc, srcCount,
+                     dstCount, first, count);
+    k->scaleNearest(g_scaleActual + TEST_GUARD, g_scaleSrc, srcCount,
+                    dstCount, first, count);
+    if (memcmp(g_scaleExpected, g_scaleActual, sizeof(g_scaleActual)) != 0)
+    {
+      printf("  %s scaleNearest: mismatch for %d -> %d, %d from %d\n",
+             blit_levelName(k->level), srcCount, dstCount, count, first);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* The SIMD blends divide by 255 as (y + 1 + (y >> 8)) >> 8. Check that for
+ * every sum the blend can produce, then every (s, d, a) through the kernel. */
+static int test_divide255(void)
+{
+  for (u32 y = 0; y <= 255u * 255u + 127u; ++y)
+  {
+    if (((y + 1u + (y >> 8)) >> 8) != y / 255u)
+    {
+      printf("  /255 shortcut wrong for %u\n", y);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int test_blendExhaustive(const BlitKernels *k)
+{
+  pixel_t expected[256];
+  pixel_t actual[256];
+  u32 src[256];
+  for (u32 a = 1; a < 256u; ++a)
+  {
+    for (u32 s = 0; s < 256u; ++s)
+    {
+      for (u32 d = 0; d < 256u; ++d)
+      {
+        // red alone meets every (s, d) pair, green and blue mirror it
+        src[d] = (a << 24) | (s << 16) | ((255u - s) << 8) | s;
+        expected[d] =
+            pixel_fromARGB(0xFF000000u | (d << 16) | (d << 8) | (255u - d));
+      }
+      memcpy(actual, expected, sizeof(expected));
+      ref_blendAlpha(expected, src, 256);
+      k->blendAlpha(actual, src, 256);
+      if (memcmp(expected, actual, sizeof(actual)) != 0)
+      {
+        printf("  %s blendAlpha: rounding differs at a=%u s=%u\n",
+               blit_levelName(k->level), a, s);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int main(void)
+{
+  int failures = test_divide255();
+  u32 lutSeed = 777u;
+  for (int i = 0; i < TEST_LUT_ENTRIES; ++i)
+    g_lut[i] = pixel_fromARGB(test_rand32(&lutSeed) | 0xFF000000u);
+  for (int level = BLIT_SCALAR; level < BLIT_LEVELS; ++level)
+  {
+    const BlitKernels *k = blit_getKernels((BlitLevel)level);
+    if (!k)
+    {
+      printf("%s: not available, skipped\n", blit_levelName((BlitLevel)level));
+      continue;
+    }
+
+    u32 seed = 12345u;
+    int levelFailures = test_rowKernels(k, &seed);
+    levelFailures += test_scaleNearest(k, &seed);
+    levelFailures += test_blendExhaustive(k);
+    printf("%s: %s\n", blit_levelName(k->level),
+           levelFailures ? "FAILED" : "ok");
+    failures += levelFailures;
+  }
+
+  printf(failures ? "FAILED\n" : "OK\n");
+  return failures ? 1 : 0;
+}
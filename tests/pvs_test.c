@@ -0,0 +1,154 @@
+// PVS against brute force sightlines on every level: make pvs_test
+#define _POSIX_C_SOURCE 199309L
+#include "map.h"
+#include "pvs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_SEGMENTS_PER_PAIR 48
+#define TEST_TOGGLES 24
+
+static u64 g_expected[PVS_TILES][PVS_WORDS];
+
+static u32 test_rand(u32 *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+static f64 test_unit(u32 *state)
+{
+  return (f64)(test_rand(state) & 0xFFFFFF) / (f64)0x1000000;
+}
+
+static f64 test_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (f64)ts.tv_sec * 1000.0 + (f64)ts.tv_nsec / 1e6;
+}
+
+// 1 when the segment crosses no solid tile, walked cell by cell in doubles
+static int test_segmentClear(f64 x0, f64 y0, f64 x1, f64 y1)
+{
+  int mapX = (int)x0;
+  int mapY = (int)y0;
+  const int endX = (int)x1;
+  const int endY = (int)y1;
+  f64 dirX = x1 - x0;
+  f64 dirY = y1 - y0;
+  f64 deltaDistX = (dirX == 0.0) ? 1e30 : 1.0 / (dirX < 0.0 ? -dirX : dirX);
+  f64 deltaDistY = (dirY == 0.0) ? 1e30 : 1.0 / (dirY < 0.0 ? -dirY : dirY);
+  int stepX = (dirX < 0.0) ? -1 : 1;
+  int stepY = (dirY < 0.0) ? -1 : 1;
+  f64 sideDistX = (dirX < 0.0) ? (x0 - mapX) * deltaDistX
+                               : (mapX + 1.0 - x0) * deltaDistX;
+  f64 sideDistY = (dirY < 0.0) ? (y0 - mapY) * deltaDistY
+                               : (mapY + 1.0 - y0) * deltaDistY;
+
+  while (mapX != endX || mapY != endY)
+  {
+    if (sideDistX < sideDistY)
+    {
+      sideDistX += deltaDistX;
+      mapX += stepX;
+    }
+    else
+    {
+      sideDistY += deltaDistY;
+      mapY += stepY;
+    }
+    if (map_isSolid(mapX, mapY))
+      return 0;
+  }
+  return 1;
+}
+
+// every pair of open tiles, random segments between them
+static int test_againstBruteForce(u32 *seed)
+{
+  int missed = 0;
+  for (int a = 0; a < PVS_TILES; ++a)
+  {
+    int ax = a / MAP_HEIGHT;
+    int ay = a % MAP_HEIGHT;
+    if (map_isSolid(ax, ay))
+      continue;
+    for (int b = a + 1; b < PVS_TILES; ++b)
+    {
+      int bx = b / MAP_HEIGHT;
+      int by = b % MAP_HEIGHT;
+      if (map_isSolid(bx, by) || pvs_testBit(a, b))
+        continue;
+      for (int s = 0; s < TEST_SEGMENTS_PER_PAIR; ++s)
+      {
+        f64 x0 = ax + test_unit(seed);
+        f64 y0 = ay + test_unit(seed);
+        f64 x1 = bx + test_unit(seed);
+        f64 y1 = by + test_unit(seed);
+        if (test_segmentClear(x0, y0, x1, y1))
+        {
+          if (missed < 8)
+            printf("  missed (%d,%d)->(%d,%d) via (%.3f,%.3f)->(%.3f,%.3f)\n",
+                   ax, ay, bx, by, x0, y0, x1, y1);
+          missed++;
+          break;
+        }
+      }
+    }
+  }
+  return missed;
+}
+
+// door toggles through the incremental path must equal a full rebuild
+static int test_incremental(u32 *seed)
+{
+  int mismatches = 0;
+  for (int t = 0; t < TEST_TOGGLES; ++t)
+  {
+    int x = 1 + (int)(test_rand(seed) % (MAP_WIDTH - 2));
+    int y = 1 + (int)(test_rand(seed) % (MAP_HEIGHT - 2));
+    map_setTile(x, y, worldMap[x][y] ? 0 : 1);
+    pvs_onTileChanged(x, y);
+    memcpy(g_expected, g_pvs, sizeof(g_pvs));
+    pvs_build();
+    if (memcmp(g_expected, g_pvs, sizeof(g_pvs)) != 0)
+    {
+      printf("  incremental mismatch after toggling (%d,%d)\n", x, y);
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+int main(void)
+{
+  int failures = 0;
+  u32 seed = 12345u;
+  for (int level = 1; level <= 5; ++level)
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "levels/%d/map.csv", level);
+    if (map_loadFromCSV(path) != 0)
+    {
+      printf("level %d: could not load %s\n", level, path);
+      failures++;
+      continue;
+    }
+
+    f64 start = test_now();
+    pvs_build();
+    f64 buildMs = test_now() - start;
+    int missed = test_againstBruteForce(&seed);
+    int mismatches = test_incremental(&seed);
+    printf("level %d: build %.1f ms, %d missed pairs, %d incremental "
+           "mismatches\n",
+           level, buildMs, missed, mismatches);
+    failures += missed + mismatches;
+  }
+
+  printf(failures ? "FAILED\n" : "OK\n");
+  return failures ? 1 : 0;
+}